@@ -32,6 +32,7 @@
 #define STA_BSY 0x80            /* Busy. */
 #define STA_DRDY 0x40           /* Device Ready. */
 #define STA_DRQ 0x08            /* Data Request. */
+#define STA_ERR 0x01            /* Error. */
 
 /* Control Register bits. */
 #define CTL_SRST 0x04           /* Software Reset. */
@@ -47,6 +48,19 @@
 #define CMD_IDENTIFY_DEVICE 0xec        /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20      /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30     /* WRITE SECTOR with retries. */
+#define CMD_READ_MULTIPLE 0xc4          /* READ MULTIPLE. */
+#define CMD_WRITE_MULTIPLE 0xc5         /* WRITE MULTIPLE. */
+#define CMD_SET_MULTIPLE_MODE 0xc6      /* SET MULTIPLE MODE. */
+
+/* Largest DRQ block we ask for with SET MULTIPLE MODE. */
+#define MAX_MULTIPLE 16
+
+/* Most sectors one command can transfer (a sector count of 0
+   would mean 256, which we do not use). */
+#define MAX_SECTORS_PER_CMD 255
+
+/* Sectors in a 4 kB page. */
+#define SECTORS_PER_4K (4096 / DISK_SECTOR_SIZE)
 
 /* An ATA device. */
 struct disk {
@@ -57,8 +71,12 @@ struct disk {
 	bool is_ata;                /* 1=This device is an ATA disk. */
 	disk_sector_t capacity;     /* Capacity in sectors (if is_ata). */
 
+	int multiple;               /* Sectors per interrupt for READ/WRITE
+								   MULTIPLE, or 0 if not supported. */
+
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	long long intr_cnt;         /* Number of completion interrupts waited. */
 };
 
 /* An ATA channel (aka controller).
@@ -85,6 +103,10 @@ static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
 static void select_sector (struct disk *, disk_sector_t);
+static void select_sectors (struct disk *, disk_sector_t, size_t cnt);
+static void read_scattered (struct disk *, disk_sector_t, size_t cnt,
+		void **bufs, size_t buf_sectors);
+static void *sector_buf (void **bufs, size_t buf_sectors, size_t idx);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -132,8 +154,9 @@ disk_init (void) {
 
 			d->is_ata = false;
 			d->capacity = 0;
+			d->multiple = 0;
 
-			d->read_cnt = d->write_cnt = 0;
+			d->read_cnt = d->write_cnt = d->intr_cnt = 0;
 		}
 
 		/* Register interrupt handler. */
@@ -167,8 +190,8 @@ disk_print_stats (void) {
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
 			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+				printf ("%s: %lld reads, %lld writes, %lld interrupts\n",
+						d->name, d->read_cnt, d->write_cnt, d->intr_cnt);
 		}
 	}
 }
@@ -228,6 +251,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
 	sema_down (&c->completion_wait);
+	d->intr_cnt++;
 	if (!wait_while_busy (d))
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
@@ -255,9 +279,136 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
+	d->intr_cnt++;
 	d->write_cnt++;
 	lock_release (&c->lock);
 }
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  Uses READ MULTIPLE when the disk supports it, so the
+   disk interrupts once per D->multiple sectors instead of once
+   per sector.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multi (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void *buffer) {
+	read_scattered (d, sec_no, cnt, &buffer, cnt);
+}
+
+/* Reads PAGE_CNT * 4 kB of consecutive sectors starting at SEC_NO
+   from disk D into PAGES[0], PAGES[1], ..., each of which must
+   have room for 4 kB.  The pages need not be adjacent in memory,
+   but the whole range is read with READ MULTIPLE as one transfer.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_pages (struct disk *d, disk_sector_t sec_no, void **pages,
+		size_t page_cnt) {
+	read_scattered (d, sec_no, page_cnt * SECTORS_PER_4K, pages,
+			SECTORS_PER_4K);
+}
+
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D.
+   The first BUF_SECTORS sectors go to BUFS[0], the next
+   BUF_SECTORS to BUFS[1], and so on. */
+static void
+read_scattered (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		void **bufs, size_t buf_sectors) {
+	struct channel *c;
+	size_t done = 0;
+
+	ASSERT (d != NULL);
+	ASSERT (bufs != NULL);
+	ASSERT (buf_sectors > 0);
+
+	if (d->multiple == 0) {
+		for (; done < cnt; done++)
+			disk_read (d, sec_no + done, sector_buf (bufs, buf_sectors, done));
+		return;
+	}
+
+	c = d->channel;
+	lock_acquire (&c->lock);
+	while (done < cnt) {
+		size_t n = cnt - done < MAX_SECTORS_PER_CMD ? cnt - done : MAX_SECTORS_PER_CMD;
+		size_t left;
+
+		select_sectors (d, sec_no + done, n);
+		issue_pio_command (c, CMD_READ_MULTIPLE);
+		for (left = n; left > 0; ) {
+			size_t block = left < (size_t) d->multiple ? left : (size_t) d->multiple;
+
+			/* One interrupt per DRQ block. */
+			sema_down (&c->completion_wait);
+			d->intr_cnt++;
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) done);
+			for (; block > 0; block--, left--, done++)
+				input_sector (c, sector_buf (bufs, buf_sectors, done));
+		}
+		d->read_cnt += n;
+	}
+	lock_release (&c->lock);
+}
+
+/* Returns where sector IDX of a read_scattered() transfer goes. */
+static void *
+sector_buf (void **bufs, size_t buf_sectors, size_t idx) {
+	return (uint8_t *) bufs[idx / buf_sectors]
+		+ idx % buf_sectors * DISK_SECTOR_SIZE;
+}
+
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   Uses WRITE MULTIPLE when the disk supports it.  Returns after
+   the disk has acknowledged receiving all of the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write_multi (struct disk *d, disk_sector_t sec_no, size_t cnt,
+		const void *buffer_) {
+	const uint8_t *buffer = buffer_;
+	struct channel *c;
+
+	ASSERT (d != NULL);
+	ASSERT (buffer != NULL);
+
+	if (d->multiple == 0) {
+		for (; cnt > 0; cnt--, sec_no++, buffer += DISK_SECTOR_SIZE)
+			disk_write (d, sec_no, buffer);
+		return;
+	}
+
+	c = d->channel;
+	lock_acquire (&c->lock);
+	while (cnt > 0) {
+		size_t n = cnt < MAX_SECTORS_PER_CMD ? cnt : MAX_SECTORS_PER_CMD;
+		size_t left;
+
+		select_sectors (d, sec_no, n);
+		issue_pio_command (c, CMD_WRITE_MULTIPLE);
+		for (left = n; left > 0; ) {
+			size_t block = left < (size_t) d->multiple ? left : (size_t) d->multiple;
+
+			/* The disk raises DRQ for each block and interrupts
+			   once it has taken the block. */
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu,
+						d->name, sec_no + (disk_sector_t) (n - left));
+			for (; block > 0; block--, left--, buffer += DISK_SECTOR_SIZE)
+				output_sector (c, buffer);
+			sema_down (&c->completion_wait);
+			d->intr_cnt++;
+		}
+		d->write_cnt += n;
+		sec_no += n;
+		cnt -= n;
+	}
+	lock_release (&c->lock);
+}
 
 /* Disk detection and identification. */
 
@@ -373,6 +524,22 @@ identify_ata_device (struct disk *d) {
 	/* Calculate capacity. */
 	d->capacity = id[60] | ((uint32_t) id[61] << 16);
 
+	/* Word 47 holds the largest DRQ block READ/WRITE MULTIPLE can
+	   use.  Turn multiple mode on with a power-of-two block. */
+	if ((id[47] & 0xff) != 0) {
+		int multiple = 1;
+		while (multiple * 2 <= (id[47] & 0xff) && multiple * 2 <= MAX_MULTIPLE)
+			multiple *= 2;
+
+		select_device_wait (d);
+		outb (reg_nsect (c), multiple);
+		issue_pio_command (c, CMD_SET_MULTIPLE_MODE);
+		sema_down (&c->completion_wait);
+		wait_while_busy (d);
+		if ((inb (reg_status (c)) & STA_ERR) == 0)
+			d->multiple = multiple;
+	}
+
 	/* Print identification message. */
 	printf ("%s: detected %'"PRDSNu" sector (", d->name, d->capacity);
 	if (d->capacity > 1024 / DISK_SECTOR_SIZE * 1024 * 1024)
@@ -415,13 +582,21 @@ print_ata_string (char *string, size_t size) {
    use LBA mode.) */
 static void
 select_sector (struct disk *d, disk_sector_t sec_no) {
+	select_sectors (d, sec_no, 1);
+}
+
+/* Like select_sector(), but selects CNT sectors starting at
+   SEC_NO, for a command that transfers more than one sector. */
+static void
+select_sectors (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
+	ASSERT (cnt > 0 && cnt <= MAX_SECTORS_PER_CMD);
+	ASSERT (sec_no + cnt <= d->capacity);
 	ASSERT (sec_no < (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -0,0 +1,135 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Local APIC of the CPU, used only for its one-shot timer. The 8259
+   PIC keeps delivering the other interrupts through LINT0, as in the
+   "virtual wire" mode the BIOS leaves the APIC in. See [IA32-v3a]
+   10.5.4 "APIC Timer". */
+
+#define MSR_APIC_BASE 0x1b
+#define APIC_BASE_ENABLE (1 << 11)      /* APIC globally enabled. */
+
+/* Register offsets. */
+#define LAPIC_ID 0x020
+#define LAPIC_EOI 0x0b0
+#define LAPIC_SVR 0x0f0                 /* Spurious interrupt vector. */
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_TIMER_INIT 0x380          /* Initial count. */
+#define LAPIC_TIMER_CUR 0x390           /* Current count. */
+#define LAPIC_TIMER_DIV 0x3e0           /* Divide configuration. */
+
+#define LVT_MASKED (1 << 16)
+#define LVT_EXTINT 0x700
+#define LVT_NMI 0x400
+#define SVR_ENABLE 0x100
+#define TIMER_DIV_16 0x3
+
+#define LAPIC_TIMER_VEC 0x40
+#define LAPIC_SPURIOUS_VEC 0xff
+
+/* Timer ticks the APIC timer is measured over at boot. */
+#define CALIBRATE_TICKS (TIMER_FREQ / 10)
+
+static volatile uint32_t *lapic;        /* Registers, mapped uncached. */
+static uint64_t timer_freq;             /* APIC timer counts per second. */
+
+static intr_handler_func spurious_interrupt;
+
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / 4];
+}
+
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / 4] = value;
+	lapic_read (LAPIC_ID);              /* Wait for the write to finish. */
+}
+
+/* Maps and enables the local APIC and measures its timer against the
+   PIT, then routes the timer's one-shot interrupts to HANDLER, which
+   must call lapic_eoi(). Returns false if the CPU has no usable local
+   APIC. Interrupts must be on. */
+bool
+lapic_timer_init (intr_handler_func *handler) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t base, pa, *pte;
+	int64_t start;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	cpuid (1, &eax, &ebx, &ecx, &edx);
+	if (!(edx & (1 << 9)))
+		return false;
+	base = read_msr (MSR_APIC_BASE);
+	if (!(base & APIC_BASE_ENABLE))
+		return false;
+
+	/* 레지스터 페이지는 RAM 밖이라 paging_init() 이 매핑하지 않는다.
+	   base_pml4 의 하위 테이블은 모든 프로세스가 공유한다. */
+	pa = base & ~(uint64_t) PGMASK & 0xffffffffffULL;
+	pte = pml4e_walk (base_pml4, (uint64_t) ptov (pa), 1);
+	if (pte == NULL)
+		return false;
+	*pte = pa | PTE_P | PTE_W | PTE_PCD;
+	lapic = ptov (pa);
+
+	intr_register_int (LAPIC_SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+			"LAPIC Spurious");
+	lapic_write (LAPIC_LVT_LINT0, LVT_EXTINT);
+	lapic_write (LAPIC_LVT_LINT1, LVT_NMI);
+	lapic_write (LAPIC_SVR, SVR_ENABLE | LAPIC_SPURIOUS_VEC);
+
+	/* 마스크한 채로 끝까지 세게 두고, PIT tick 몇 개 동안 줄어든 양을 잰다. */
+	lapic_write (LAPIC_TIMER_DIV, TIMER_DIV_16);
+	lapic_write (LAPIC_LVT_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	start = timer_ticks ();
+	while (timer_ticks () == start)
+		barrier ();
+	lapic_write (LAPIC_TIMER_INIT, UINT32_MAX);
+	start = timer_ticks ();
+	while (timer_elapsed (start) < CALIBRATE_TICKS)
+		barrier ();
+	timer_freq = (uint64_t) (UINT32_MAX - lapic_read (LAPIC_TIMER_CUR))
+		* TIMER_FREQ / CALIBRATE_TICKS;
+	lapic_write (LAPIC_TIMER_INIT, 0);
+	if (timer_freq == 0)
+		return false;
+
+	intr_register_int (LAPIC_TIMER_VEC, 0, INTR_OFF, handler, "LAPIC Timer");
+	lapic_write (LAPIC_LVT_TIMER, LAPIC_TIMER_VEC);    /* One-shot. */
+	return true;
+}
+
+/* Returns the APIC timer's counts per second. */
+uint64_t
+lapic_timer_freq (void) {
+	return timer_freq;
+}
+
+/* Makes the APIC timer interrupt once, COUNT counts from now.
+   A COUNT of 0 stops it. */
+void
+lapic_timer_arm (uint32_t count) {
+	lapic_write (LAPIC_TIMER_INIT, count);
+}
+
+/* Acknowledges the interrupt being handled to the local APIC. */
+void
+lapic_eoi (void) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* Spurious interrupts need no EOI. */
+static void
+spurious_interrupt (struct intr_frame *args UNUSED) {
+}
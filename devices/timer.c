@@ -1,5 +1,6 @@
 #include "devices/timer.h"
 #include <debug.h>
+#include "devices/lapic.h"
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
@@ -7,6 +8,7 @@
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 //전처리기 지시자
@@ -18,14 +20,100 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, and that divided by TIMER_FREQ, rounded to
+   nearest: the count of one timer tick.
+   korean : 8254의 input frequency를 TIMER_FREQ로 나누고, 가장 가까운 값으로 반올림한다. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Most ticks one 16-bit one-shot count can span. */
+#define ONESHOT_MAX_TICKS (0xffff / PIT_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Tickless idle, turned on at boot with "-tickless". While the idle
+   thread halts, the PIT is put in one-shot mode up to the next tick
+   that has work to do, and the ticks in between are accounted by the
+   one interrupt that ends it. */
+bool timer_tickless;
+static int oneshot_ticks;       /* Ticks passed when the one-shot fires, 0 if periodic. */
+static int oneshot_idle;        /* How many of those were spent halted, -1 until woken. */
+static unsigned oneshot_count;  /* PIT count the one-shot was last set to. */
+static long long idle_sleeps;   /* Times the idle thread stopped the tick. */
+static long long idle_wakeups;  /* ...and was woken early by another interrupt. */
+static long long ticks_skipped; /* Timer interrupts saved. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Clock sources of timer_now_ns(): the PIT (the ticks plus the count
+   of the current one) until timer_calibrate() measures the TSC against
+   it, then the TSC if it is invariant, i.e. runs at the same rate in
+   every power state. */
+struct clocksource {
+	const char *name;
+	uint64_t (*read) (void);        /* Monotonic counter. */
+	uint64_t freq;                  /* Counts per second. */
+};
+
+static uint64_t pit_clock_read (void);
+static uint64_t tsc_clock_read (void);
+static struct clocksource pit_clock = { "pit", pit_clock_read, PIT_HZ };
+static struct clocksource tsc_clock = { "tsc", tsc_clock_read, 0 };
+static struct clocksource *cur_clock = &pit_clock;
+static uint64_t clock_base;         /* cur_clock->read () when it was picked. */
+static uint64_t clock_base_ns;      /* timer_now_ns () at that moment. */
+
+/* Timer ticks the TSC is measured over at boot. */
+#define CALIBRATE_TICKS (TIMER_FREQ / 10)
+
+/* Sub-tick sleeps on the local APIC timer, turned on at boot with
+   "-lapic-timer". Sleepers are kept soonest first, and the APIC timer
+   is armed for the first one. */
+bool timer_lapic;
+
+struct hr_sleeper {
+	uint64_t deadline;              /* timer_now_ns () to wake at. */
+	struct thread *thread;
+	struct list_elem elem;          /* hr_sleepers. */
+};
+
+static struct list hr_sleepers;
+static long long hr_sleeps;         /* Sleeps that blocked on the APIC timer. */
+
+/* Hierarchical timer wheel of timer events. Level L has WHEEL_SIZE
+   slots of WHEEL_SIZE^L ticks each, so the wheel reaches WHEEL_RANGE
+   ticks ahead. An event goes into the lowest level whose range holds
+   its expiry. Each tick runs one slot of level 0; whenever a level
+   comes round to slot 0, the next slot of the level above is cascaded
+   down, so an event moves at most WHEEL_LEVELS - 1 times before it
+   runs. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1LL << (WHEEL_BITS * WHEEL_LEVELS))
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+static int64_t wheel_next;              /* Next tick whose slot is run. */
+static long long timer_run_cnt;         /* Events run. */
+static long long timer_cascade_cnt;     /* Events moved down a level. */
+
 static intr_handler_func timer_interrupt;
+static void timer_tick (bool idle);
+static void pit_periodic (void);
+static void pit_oneshot (unsigned count);
+static unsigned pit_read (void);
+static int64_t oneshot_passed (void);
+static void clock_select (struct clocksource *);
+static bool tsc_invariant (void);
+static void hr_sleep (int64_t ns);
+static void hr_arm (uint64_t deadline);
+static intr_handler_func hr_interrupt;
+static void wheel_insert (struct timer_event *);
+static void wheel_run (void);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -38,18 +126,15 @@ static void real_time_sleep (int64_t num, int32_t denom);
 	해당 인터럽트를 등록한다.*/
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. 
-	   --------------------------------------------------------
-	   korean : 8254의 input frequency를 TIMER_FREQ로 나누고, 가장 가까운 값으로 반올림한다.
-	   8254 타이머의 입력 주파수를 TIMER_FREQ 값으로 조절하려는 의도를 설명한다. 
-	   이를 통해 원하는 타이밍 빈도로 타이머를 설정할 수 있다.*/
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-	/*outb(port, data)*/
-	//0x43 : PIT, 0x34 : PIT의 스펙
-	outb (0x43, 0x34);    //타이머를 깨운다 /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	int level, i;
+
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (i = 0; i < WHEEL_SIZE; i++)
+			list_init (&wheel[level][i]);
+	wheel_next = ticks;
+	list_init (&hr_sleepers);
+
+	pit_periodic ();
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -77,13 +162,38 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	if (tsc_invariant ()) {
+		int64_t start = ticks;
+		uint64_t tsc;
+
+		while (ticks == start)
+			barrier ();
+		tsc = rdtsc ();
+		start = ticks;
+		while (ticks - start < CALIBRATE_TICKS)
+			barrier ();
+		tsc_clock.freq = (rdtsc () - tsc) * TIMER_FREQ / CALIBRATE_TICKS;
+		clock_select (&tsc_clock);
+	}
+	printf ("Clocksource: %s, %'"PRIu64" Hz.\n", cur_clock->name, cur_clock->freq);
+
+	/* 준비가 끝나기 전에는 real_time_sleep() 이 APIC timer 를 쓰지 않게 한다. */
+	if (timer_lapic) {
+		timer_lapic = false;
+		if (lapic_timer_init (hr_interrupt)) {
+			timer_lapic = true;
+			printf ("LAPIC timer: %'"PRIu64" Hz.\n", lapic_timer_freq ());
+		} else
+			printf ("LAPIC timer: not available, sub-tick sleeps will spin.\n");
+	}
 }
 
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks (void) {
 	enum intr_level old_level = intr_disable ();
-	int64_t t = ticks;
+	int64_t t = ticks + oneshot_passed ();
 	intr_set_level (old_level);
 	barrier ();
 	return t;
@@ -96,6 +206,18 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns the nanoseconds since the OS booted, from the best clock
+   source available. */
+uint64_t
+timer_now_ns (void) {
+	uint64_t delta = cur_clock->read () - clock_base;
+	uint64_t freq = cur_clock->freq;
+
+	/* 곱셈이 넘치지 않도록 초 단위와 나머지를 나눠 바꾼다. */
+	return clock_base_ns + delta / freq * 1000000000
+		+ delta % freq * 1000000000 / freq;
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 //timer가 적어도 x번 tic할때까지 thread 호출의 실행을 일시 중단한다. 시스템이 idle(다음 thread가 없는) 상태가 아니면,
 //thread가 정확히 x번의 tick이 발생한 직후에 wake up할 필요가 없다.
@@ -136,16 +258,212 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %"PRId64" ticks, %lld events run, %lld cascaded\n",
+			timer_ticks (), timer_run_cnt, timer_cascade_cnt);
+	if (timer_tickless)
+		printf ("Timer: %lld idle sleeps, %lld early wakeups, %lld ticks skipped\n",
+				idle_sleeps, idle_wakeups, ticks_skipped);
+	if (timer_lapic)
+		printf ("Timer: %lld LAPIC sleeps\n", hr_sleeps);
+}
+
+/* Initializes EV to call FUNC with AUX when it expires. */
+void
+timer_event_init (struct timer_event *ev, timer_func *func, void *aux) {
+	ASSERT (ev != NULL);
+	ASSERT (func != NULL);
+
+	ev->func = func;
+	ev->aux = aux;
+	ev->pending = false;
+}
+
+/* Arms EV to run at tick EXPIRES, or on the next tick if EXPIRES has
+   already passed. EV must not be pending. May be called from an
+   interrupt handler, including from another event's callback. */
+void
+timer_event_add (struct timer_event *ev, int64_t expires) {
+	enum intr_level old_level = intr_disable ();
+
+	ASSERT (!ev->pending);
+	ev->expires = expires;
+	ev->pending = true;
+	wheel_insert (ev);
+	intr_set_level (old_level);
+}
+
+/* Disarms EV. Returns true if it was pending, false if it had already
+   run (or was never added). */
+bool
+timer_event_cancel (struct timer_event *ev) {
+	enum intr_level old_level = intr_disable ();
+	bool pending = ev->pending;
+
+	if (pending) {
+		list_remove (&ev->elem);
+		ev->pending = false;
+	}
+	intr_set_level (old_level);
+	return pending;
+}
+
+/* Puts EV into the wheel slot of its expiry. Interrupts must be off. */
+static void
+wheel_insert (struct timer_event *ev) {
+	int64_t delta = ev->expires - wheel_next;
+	int64_t pos = ev->expires;
+	int level;
+
+	if (delta < 0) {
+		/* 이미 지난 시각이면 다음 tick 에 돈다. */
+		delta = 0;
+		pos = wheel_next;
+	} else if (delta >= WHEEL_RANGE) {
+		/* 바퀴보다 멀면 맨 끝 칸에 두고, 내려올 때 expires 로 다시 넣는다. */
+		delta = WHEEL_RANGE - 1;
+		pos = wheel_next + delta;
+	}
+	for (level = 0; delta >= 1LL << (WHEEL_BITS * (level + 1)); level++)
+		continue;
+	list_push_back (&wheel[level][(pos >> (WHEEL_BITS * level)) & WHEEL_MASK],
+			&ev->elem);
+}
+
+/* Runs the events due at tick wheel_next and advances it. */
+static void
+wheel_run (void) {
+	int index = wheel_next & WHEEL_MASK;
+	struct list *slot = &wheel[0][index];
+	struct list due;
+	int level, i;
+
+	/* 아래 레벨이 한 바퀴 돌았으면 위 레벨의 다음 칸을 내려 보낸다. */
+	for (level = 1, i = index; i == 0 && level < WHEEL_LEVELS; level++) {
+		struct list *upper;
+
+		i = (wheel_next >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		upper = &wheel[level][i];
+		while (!list_empty (upper)) {
+			wheel_insert (list_entry (list_pop_front (upper),
+						struct timer_event, elem));
+			timer_cascade_cnt++;
+		}
+	}
+	wheel_next++;
+
+	/* 콜백이 같은 칸에 새 event 를 넣을 수 있으니 먼저 떼어 낸다. */
+	list_init (&due);
+	while (!list_empty (slot))
+		list_push_back (&due, list_pop_front (slot));
+	while (!list_empty (&due)) {
+		struct timer_event *ev = list_entry (list_pop_front (&due),
+				struct timer_event, elem);
+
+		ev->pending = false;
+		timer_run_cnt++;
+		ev->func (ev->aux);
+	}
 }
 
+/* Returns true if wheel_run() moves any event down a level at tick T.
+   A tick that only brings round empty upper slots changes nothing. */
+static bool
+wheel_cascades (int64_t t) {
+	int level, i;
+
+	for (level = 1, i = t & WHEEL_MASK; i == 0 && level < WHEEL_LEVELS; level++) {
+		i = (t >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		if (!list_empty (&wheel[level][i]))
+			return true;
+	}
+	return false;
+}
+
+/* Called by the idle thread, with interrupts off, right before it
+   halts. In tickless mode, stops the periodic tick until the first
+   tick that has timer events to run, a wheel cascade that moves
+   events or (mlfqs) a load average update, at most ONESHOT_MAX_TICKS
+   away. The ticks skipped are run through the wheel one by one when
+   the one-shot fires, so empty cascades need no tick of their own. */
+void
+timer_idle_enter (void) {
+	unsigned remaining;
+	int64_t t;
+	int n;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless || oneshot_ticks != 0)
+		return;
+	for (t = ticks + 1; t < ticks + ONESHOT_MAX_TICKS; t++)
+		if (!list_empty (&wheel[0][t & WHEEL_MASK]) || wheel_cascades (t)
+				|| (thread_mlfqs && t % TIMER_FREQ == 0))
+			break;
+	n = t - ticks;
+	if (n <= 1)
+		return;
+
+	/* 다음 tick 까지 남은 count 를 이어 붙여 tick 의 위상을 유지한다.
+	   곧 tick 이 오거나 이미 와서 IRQ 가 걸려 있으면 그냥 둔다. */
+	remaining = pit_read ();
+	outb (0x20, 0x0a);                  /* OCW3: read the master PIC's IRR. */
+	if (remaining < PIT_COUNT / 16 || remaining > PIT_COUNT || (inb (0x20) & 1))
+		return;
+	pit_oneshot (remaining + (n - 1) * PIT_COUNT);
+	oneshot_ticks = n;
+	oneshot_idle = -1;
+	idle_sleeps++;
+}
+
+/* Called by the idle thread after it wakes up. If another interrupt
+   woke it before the one-shot fired, moves the one-shot in to the
+   next tick boundary so the periodic tick comes back at once. */
+void
+timer_idle_exit (void) {
+	enum intr_level old_level = intr_disable ();
+
+	if (oneshot_ticks != 0 && oneshot_idle < 0) {
+		unsigned remaining = pit_read ();
+
+		oneshot_idle = oneshot_passed ();
+		/* 남은 게 한 tick 이 안 되면 곧 알아서 터진다. */
+		if (remaining > PIT_COUNT && remaining <= oneshot_count) {
+			pit_oneshot ((remaining - 1) % PIT_COUNT + 1);
+			oneshot_ticks = oneshot_idle + 1;
+		}
+		idle_wakeups++;
+	}
+	intr_set_level (old_level);
+}
+
 /* Timer interrupt handler. */
 /* 이후 프로젝트에서 에러시 timer_ticks() -> ticks 변경 ? */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	int n = 1, idle = 0, i;
+
+	/* one-shot 이 끝났으면 그동안의 tick 을 한꺼번에 센다. */
+	if (oneshot_ticks != 0) {
+		n = oneshot_ticks;
+		idle = oneshot_idle > 0 ? oneshot_idle : 0;
+		oneshot_ticks = oneshot_idle = 0;
+		pit_periodic ();
+		ticks_skipped += n - 1;
+	}
+	for (i = 0; i < n; i++)
+		timer_tick (i < idle);
+}
+
+/* Accounts one timer tick. IDLE means the tick passed while the idle
+   thread was halted, whichever thread runs now. */
+static void
+timer_tick (bool idle) {
 	ticks++;
-	thread_tick ();
-	if (thread_mlfqs){ // mlfqs 관련 변경
+	if (idle)
+		thread_tick_idle ();
+	else
+		thread_tick ();
+	if (thread_mlfqs && !idle){ // mlfqs 관련 변경
 		mlfqs_increment();
 		if (timer_ticks() % 4 == 0){
 			mlfqs_priority(thread_current());
@@ -155,9 +473,189 @@ timer_interrupt (struct intr_frame *args UNUSED) {
 			}
 		}
 	}
-	/* per every tick(1ms), check if there are any threads to be awaken */
-	if(get_next_tick_to_awake() <= ticks) // if the first candidate of sleep list needds to be awaken (== if there's at least 1 thread to be awaken)
-		thread_awake(ticks); // alarm-multiple 관련 변경 // by calling thread_awake(), check every threads in the sleep list and wakeup if necessary
+	/* 이번 tick 에 만료되는 timer event (잠든 스레드 포함) 만 돈다. */
+	while (wheel_next <= ticks)
+		wheel_run ();
+}
+
+/* Sets the PIT to interrupt every tick. */
+static void
+pit_periodic (void) {
+	/*outb(port, data)*/
+	//0x43 : PIT, 0x34 : PIT의 스펙
+	outb (0x43, 0x34);    //타이머를 깨운다 /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, PIT_COUNT & 0xff);
+	outb (0x40, PIT_COUNT >> 8);
+}
+
+/* Sets the PIT to interrupt once, COUNT input clocks from now. */
+static void
+pit_oneshot (unsigned count) {
+	ASSERT (count > 0 && count <= 0xffff);
+
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+	oneshot_count = count;
+}
+
+/* Returns the current count of PIT counter 0. */
+static unsigned
+pit_read (void) {
+	unsigned lo, hi;
+
+	outb (0x43, 0x00);    /* Latch counter 0. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | hi << 8;
+}
+
+/* Ticks that have passed since the last timer interrupt but are not
+   yet accounted, because the PIT is in one-shot mode. Interrupts must
+   be off. */
+static int64_t
+oneshot_passed (void) {
+	unsigned remaining;
+
+	if (oneshot_ticks == 0)
+		return 0;
+	remaining = pit_read ();
+	/* 0 을 지나 한 바퀴 돌았으면 마지막 tick 의 interrupt 를 기다리는 중. */
+	if (remaining == 0 || remaining > oneshot_count)
+		return oneshot_ticks - 1;
+	return oneshot_ticks - 1 - (remaining - 1) / PIT_COUNT;
+}
+
+/* Switches timer_now_ns() to CLOCK, carrying on from the time the
+   old clock source reads now. */
+static void
+clock_select (struct clocksource *clock) {
+	enum intr_level old_level = intr_disable ();
+
+	clock_base_ns = timer_now_ns ();
+	clock_base = clock->read ();
+	cur_clock = clock;
+	intr_set_level (old_level);
+}
+
+/* Returns true if the CPU says its TSC is invariant
+   (CPUID 0x80000007, EDX bit 8). */
+static bool
+tsc_invariant (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	cpuid (0x80000000, &eax, &ebx, &ecx, &edx);
+	if (eax < 0x80000007)
+		return false;
+	cpuid (0x80000007, &eax, &ebx, &ecx, &edx);
+	return (edx & (1 << 8)) != 0;
+}
+
+static uint64_t
+tsc_clock_read (void) {
+	return rdtsc ();
+}
+
+/* Reads the PIT as a counter of PIT_HZ: the ticks so far times
+   PIT_COUNT, plus how far the current tick has counted. */
+static uint64_t
+pit_clock_read (void) {
+	static uint64_t last;
+	enum intr_level old_level = intr_disable ();
+	unsigned remaining = pit_read ();
+	int64_t t = ticks;
+	unsigned partial;
+	uint64_t now;
+
+	if (oneshot_ticks != 0) {
+		if (remaining == 0 || remaining > oneshot_count) {
+			t += oneshot_ticks - 1;
+			partial = PIT_COUNT - 1;
+		} else {
+			t += oneshot_ticks - 1 - (remaining - 1) / PIT_COUNT;
+			partial = PIT_COUNT - ((remaining - 1) % PIT_COUNT + 1);
+		}
+	} else {
+		partial = remaining != 0 && remaining <= PIT_COUNT ? PIT_COUNT - remaining : 0;
+		/* 방금 tick 을 지났는데 interrupt 가 아직 처리되지 않았으면 센다. */
+		outb (0x20, 0x0a);              /* OCW3: read the master PIC's IRR. */
+		if ((inb (0x20) & 1) && partial < PIT_COUNT / 2)
+			t++;
+	}
+	now = (uint64_t) t * PIT_COUNT + partial;
+	if (now < last)
+		now = last;
+	last = now;
+	intr_set_level (old_level);
+	return now;
+}
+
+/* Orders hr_sleepers by deadline. */
+static bool
+hr_sleeper_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct hr_sleeper *a = list_entry (a_, struct hr_sleeper, elem);
+	const struct hr_sleeper *b = list_entry (b_, struct hr_sleeper, elem);
+
+	return a->deadline < b->deadline;
+}
+
+/* Blocks the current thread for NS nanoseconds, less than a tick, on
+   the local APIC timer. */
+static void
+hr_sleep (int64_t ns) {
+	struct hr_sleeper s;
+	enum intr_level old_level;
+
+	s.deadline = timer_now_ns () + ns;
+	s.thread = thread_current ();
+	old_level = intr_disable ();
+	list_insert_ordered (&hr_sleepers, &s.elem, hr_sleeper_less, NULL);
+	if (list_front (&hr_sleepers) == &s.elem)
+		hr_arm (s.deadline);
+	hr_sleeps++;
+	thread_block ();
+	intr_set_level (old_level);
+}
+
+/* Arms the APIC timer to go off at DEADLINE. Interrupts must be off. */
+static void
+hr_arm (uint64_t deadline) {
+	uint64_t now = timer_now_ns ();
+	uint64_t count = 1;
+
+	if (deadline > now)
+		count = (deadline - now) * lapic_timer_freq () / 1000000000 + 1;
+	lapic_timer_arm (count < UINT32_MAX ? count : UINT32_MAX);
+}
+
+/* APIC timer interrupt handler: wakes the sub-tick sleepers that are
+   due and arms the timer for the next one. */
+static void
+hr_interrupt (struct intr_frame *args UNUSED) {
+	uint64_t now = timer_now_ns ();
+	struct thread *woken = NULL;
+
+	lapic_eoi ();
+	while (!list_empty (&hr_sleepers)) {
+		struct hr_sleeper *s = list_entry (list_front (&hr_sleepers),
+				struct hr_sleeper, elem);
+
+		if (s->deadline > now)
+			break;
+		list_pop_front (&hr_sleepers);
+		thread_unblock (s->thread);
+		if (woken == NULL || s->thread->priority > woken->priority)
+			woken = s->thread;
+	}
+	if (!list_empty (&hr_sleepers))
+		hr_arm (list_entry (list_front (&hr_sleepers), struct hr_sleeper,
+					elem)->deadline);
+
+	/* 외부 인터럽트가 아니라 intr_yield_on_return() 을 쓸 수 없으니,
+	   EOI 를 보낸 뒤 직접 양보한다. */
+	if (woken != NULL && woken->priority > thread_current ()->priority)
+		thread_yield ();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -208,6 +706,9 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
+	} else if (timer_lapic) {
+		/* tick 보다 짧으면 local APIC timer 로 잠든다. */
+		hr_sleep (num * 1000000000 / denom);
 	} else {
 		/* Otherwise, use a busy-wait loop for more accurate
 		   sub-tick timing.  We scale the numerator and denominator
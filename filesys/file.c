@@ -81,6 +81,17 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
 	return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads SIZE bytes from FILE into PAGES[0], PAGES[1], ...,
+ * PGSIZE bytes each, starting at offset FILE_OFS in the file.
+ * The pages need not be adjacent in memory.
+ * Returns the number of bytes actually read,
+ * which may be less than SIZE if end of file is reached.
+ * The file's current position is unaffected. */
+off_t
+file_read_pages (struct file *file, void **pages, off_t size, off_t file_ofs) {
+	return inode_read_pages (file->inode, pages, size, file_ofs);
+}
+
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/vaddr.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -201,8 +202,18 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 			break;
 
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
+			/* Read full sectors directly into caller's buffer.  Take
+			 * every following full sector that is next to this one
+			 * on disk and read them all with one command. */
+			size_t sector_cnt = 1;
+			while ((off_t) ((sector_cnt + 1) * DISK_SECTOR_SIZE) <= size
+					&& (off_t) ((sector_cnt + 1) * DISK_SECTOR_SIZE) <= inode_left
+					&& byte_to_sector (inode, offset + sector_cnt * DISK_SECTOR_SIZE)
+					== sector_idx + sector_cnt)
+				sector_cnt++;
+			disk_read_multi (filesys_disk, sector_idx, sector_cnt,
+					buffer + bytes_read);
+			chunk_size = sector_cnt * DISK_SECTOR_SIZE;
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
@@ -225,6 +236,37 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	return bytes_read;
 }
 
+/* Reads SIZE bytes from INODE, starting at position OFFSET, into
+ * PAGES[0], PAGES[1], ..., PGSIZE bytes each, which need not be
+ * adjacent in memory.  When OFFSET is sector aligned the whole pages
+ * are read with one disk command (disk_read_pages()); the rest goes
+ * through inode_read_at().  Returns the number of bytes actually
+ * read, which may be less than SIZE if an error occurs or end of
+ * file is reached. */
+off_t
+inode_read_pages (struct inode *inode, void **pages, off_t size, off_t offset) {
+	off_t bytes_read = 0;
+	size_t page_cnt = size / PGSIZE;
+	size_t i;
+
+	/* Data sectors of an inode are consecutive on disk. */
+	if (page_cnt > 0 && offset % DISK_SECTOR_SIZE == 0
+			&& offset + (off_t) (page_cnt * PGSIZE) <= inode_length (inode)) {
+		disk_read_pages (filesys_disk, byte_to_sector (inode, offset), pages,
+				page_cnt);
+		bytes_read = page_cnt * PGSIZE;
+	}
+	for (i = bytes_read / PGSIZE; bytes_read < size; i++) {
+		off_t chunk = size - bytes_read < PGSIZE ? size - bytes_read : PGSIZE;
+		off_t n = inode_read_at (inode, pages[i], chunk, offset + bytes_read);
+
+		bytes_read += n;
+		if (n != chunk)
+			break;
+	}
+	return bytes_read;
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
  * less than SIZE if end of file is reached or an error occurs.
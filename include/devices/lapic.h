@@ -0,0 +1,13 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+bool lapic_timer_init (intr_handler_func *handler);
+uint64_t lapic_timer_freq (void);
+void lapic_timer_arm (uint32_t count);
+void lapic_eoi (void);
+
+#endif /* devices/lapic.h */
@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -12,6 +14,7 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+uint64_t timer_now_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +23,31 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Tickless idle, turned on at boot with "-tickless". */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+/* Sub-tick sleeps on the local APIC timer, turned on at boot with
+   "-lapic-timer". */
+extern bool timer_lapic;
+
+/* A callback run from the timer interrupt at a given tick, with
+   interrupts off. Events are kept in a hierarchical timer wheel
+   (timer.c), so adding and cancelling one is O(1) and each tick
+   only looks at the events that are due. */
+typedef void timer_func (void *aux);
+
+struct timer_event {
+	int64_t expires;            /* Tick to run at. */
+	timer_func *func;           /* Callback. */
+	void *aux;                  /* Its argument. */
+	bool pending;               /* In the wheel, not yet run. */
+	struct list_elem elem;      /* Wheel slot. */
+};
+
+void timer_event_init (struct timer_event *, timer_func *, void *aux);
+void timer_event_add (struct timer_event *, int64_t expires);
+bool timer_event_cancel (struct timer_event *);
+
 #endif /* devices/timer.h */
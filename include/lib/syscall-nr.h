@@ -36,6 +36,10 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MSYNC,                  /* Write a memory mapping back to its file. */
+	SYS_MADVISE,                /* Give the access pattern of a range. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -13,6 +13,23 @@ typedef int pid_t;
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
 
+/* Access pattern hints for madvise(). */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_RANDOM 1           /* Do not read ahead on faults. */
+#define MADV_SEQUENTIAL 2       /* Read far ahead, evict pages behind. */
+#define MADV_WILLNEED 3         /* Read the pages in the background. */
+#define MADV_DONTNEED 4         /* Free the pages now. */
+
+/* Page fault causes for get_page_fault_stat(). */
+#define FAULT_UNINIT 0          /* First touch of a page loaded from a file. */
+#define FAULT_ZERO 1            /* First touch of a fresh anonymous page. */
+#define FAULT_SWAP 2            /* Anonymous page back from swap. */
+#define FAULT_FILE 3            /* File-backed page read back after eviction. */
+#define FAULT_STACK 4           /* Stack growth. */
+#define FAULT_COW 5             /* Write to a shared read-only page. */
+#define FAULT_BAD 6             /* Not handled: the process is killed. */
+#define FAULT_HIST_BUCKETS 16   /* Latency buckets, from 2^10 TSC cycles. */
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -41,6 +58,8 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int madvise (void *addr, size_t length, int advice);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -78,4 +97,17 @@ get_fs_disk_write_cnt (void) {
 	return write_cnt;
 }
 
+/* Reads page fault statistics of CAUSE: the number of faults whose
+   latency fell in histogram BUCKET, or with BUCKET ==
+   FAULT_HIST_BUCKETS, the number of faults in all. */
+static inline long long
+get_page_fault_stat (int cause, int bucket) {
+	long long cnt;
+	asm volatile ("int $0x45"
+	              : "=a" (cnt)
+	              : "d" ((long long) cause), "c" ((long long) bucket)
+	              : "memory");
+	return cnt;
+}
+
 #endif /* lib/user/syscall.h */
@@ -17,7 +17,13 @@ extern size_t user_page_limit;
 uint64_t palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned (enum palloc_flags, size_t page_cnt, size_t align_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+size_t palloc_user_free_cnt (void);
+size_t palloc_user_page_cnt (void);
+size_t palloc_user_span (void);
+size_t palloc_user_index (const void *);
+void *palloc_user_page (size_t idx);
 
 #endif /* threads/palloc.h */
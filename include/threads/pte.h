@@ -28,6 +28,13 @@
 #define PTX(la)  ((((uint64_t) (la)) >> PTXSHIFT) & 0x1FF)
 #define PTE_ADDR(pte) ((uint64_t) (pte) & ~0xFFF)
 
+/* A page directory entry with PTE_PS set maps a whole 2 MiB large
+ * page instead of pointing to a page table. */
+#define LARGE_PGSIZE (1UL << PDXSHIFT)
+#define LARGE_PGCNT (LARGE_PGSIZE / PGSIZE)
+#define large_pg_round_down(va) ((void *) ((uint64_t) (va) & ~(LARGE_PGSIZE - 1)))
+#define large_pg_ofs(va) ((uint64_t) (va) & (LARGE_PGSIZE - 1))
+
 /* The important flags are listed below.
    When a PDE or PTE is not "present", the other flags are
    ignored.
@@ -39,7 +46,9 @@
 #define PTE_P 0x1                        /* 1=present, 0=not present. */
 #define PTE_W 0x2                        /* 1=read/write, 0=read-only. */
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
+#define PTE_PCD 0x10                     /* 1=cache disabled (device memory). */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=2 MiB page (PDEs only). */
 
 #endif /* threads/pte.h */
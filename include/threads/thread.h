@@ -95,8 +95,6 @@ struct thread
 	int priority;			   /* Priority. */
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;															  /* List element. */
-	struct list_elem all_elem; /* List element for all_list */						  // mlfqs 관련 변경
-	int64_t wakeup_tick; /* Local ticks (minimum ticks required before awakened )  */ /* alarm-multiple 관련 변경 */
 
 	/* donation 관련 */
 	int init_priority; /* default priority (to initialize after return donated priority) */ // priority-donate 관련 변경
@@ -106,6 +104,7 @@ struct thread
 	/* advanced */
 	int nice; /* nice value of thread */											   // mlfqs 관련 변경
 	int recent_cpu; /* recent_cpu which estimates how much CPU time earned recently */ // mlfqs 관련 변경
+	int64_t mlfqs_epoch; /* mlfqs_recalc() pass that recent_cpu is up to date with */ // mlfqs 관련 변경
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -114,6 +113,7 @@ struct thread
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
+	int fault_cause; /* 처리 중인 page fault 의 원인 (enum fault_cause). vm_try_handle_fault 가 정한다 */
 #endif
 
 	/* Owned by thread.c. */
@@ -152,6 +152,7 @@ void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
+void thread_tick_idle(void);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
@@ -179,9 +180,6 @@ void do_iret(struct intr_frame *tf);
 
 /* alarm-multiple 관련 변경 */
 void thread_sleep(int64_t ticks);
-void thread_awake(int64_t ticks);
-void update_next_tick_to_awake(int64_t ticks);
-int64_t get_next_tick_to_awake(void);
 
 /* alarm-priority, priority-fifo/preempt 관련 변경 */
 void check_curr_max_priority(void);
@@ -6,6 +6,26 @@
 #define PF_W 0x2    /* 0: read, 1: write. */
 #define PF_U 0x4    /* 0: kernel, 1: user process. */
 
+/* What a page fault needed, for the fault statistics. The values are
+   those of the FAULT_* constants in lib/user/syscall.h. */
+enum fault_cause
+  {
+    FAULT_UNINIT,       /* First touch of a page loaded from a file. */
+    FAULT_ZERO,         /* First touch of a fresh anonymous page. */
+    FAULT_SWAP,         /* Anonymous page back from swap or zswap. */
+    FAULT_FILE,         /* File-backed page read back after eviction. */
+    FAULT_STACK,        /* Stack growth. */
+    FAULT_COW,          /* Write to a shared read-only page. */
+    FAULT_BAD,          /* Not handled: the process is killed. */
+    FAULT_CAUSE_CNT
+  };
+
+/* Fault latency histogram: bucket 0 counts faults under
+   2**FAULT_HIST_SHIFT TSC cycles, each next bucket doubles that, and
+   the last one takes everything slower. */
+#define FAULT_HIST_BUCKETS 16
+#define FAULT_HIST_SHIFT 10
+
 void exception_init (void);
 void exception_print_stats (void);
 
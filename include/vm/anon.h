@@ -2,15 +2,22 @@
 #define VM_ANON_H
 #include "vm/vm.h"
 struct page;
+struct zswap_entry;
+struct supplemental_page_table;
 enum vm_type;
 
 struct anon_page
 {
     // TODO - 몇가지 정보 추가
     int swap_sec;
+    bool readahead; /* swap readahead 로 올라왔고 아직 한 번도 매핑되지 않음 */
+    struct zswap_entry *zswap; /* 압축되어 zswap 풀에 있으면 그 entry */
 };
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+void anon_readahead_feedback(struct page *page, bool hit);
+void anon_readahead_init(struct supplemental_page_table *spt);
+void vm_anon_print_stats(void);
 
 #endif
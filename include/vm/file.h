@@ -13,6 +13,7 @@ struct file_page
 	size_t length;
 	uint32_t read_bytes;
 	uint32_t zero_bytes;
+	bool segment; /* 실행 파일의 읽기 전용 세그먼트. 쫓겨나면 버리고 다시 읽는다 */
 };
 
 void vm_file_init(void);
@@ -20,6 +21,9 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 			  struct file *file, off_t offset);
 void do_munmap(void *va);
+int do_msync(void *addr, size_t length);
+bool file_backed_writeback(struct page *page);
+void file_backed_write(struct page *page);
 #endif
 
 //swap
@@ -50,8 +50,9 @@ struct page
 	struct frame *frame; /* 이 페이지가 매핑된 물리 프레임. 해당 프레임이 물리 메모리에서 어디에 위치하는지 */
 
 	/* Your implementation */
-	struct hash_elem hash_elem;
 	bool writable;
+	struct thread *owner; /* 이 페이지를 가진 프로세스. eviction 때 owner의 pml4를 봐야 함 */
+	struct list_elem share_elem; /* frame->pages 에 들어가는 elem (COW 공유) */
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
 	// 각 타입별로 필요한 데이터만 저장하기
@@ -70,14 +71,78 @@ struct page
 	struct list lru_list;
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * There is one for every page of the user pool, in frame_table (vm.c),
+ * found from the kva by palloc_user_index(); frames are never
+ * allocated or freed, only taken into use and out of it. */
 struct frame
 {
 	void *kva;
 	struct page *page;
-	struct list_elem frame_elem;
+	uint8_t state;	   /* FRAME_* 비트. frame_lock 을 잡고 바꾼다 */
+	uint64_t stamp;	   /* 사용하기 시작한 순서. FIFO eviction 이 본다 */
+	struct list pages; /* 이 프레임을 공유하는 페이지들 (fork 후 COW) */
+	int ref_cnt;	   /* pages 의 원소 수. 1보다 크면 read-only 로 공유 중 */
+	int hold_cnt;	   /* frame_lock 을 놓고 이 프레임을 쓰는 스레드 수 (frame_hold) */
+	struct hash_elem ksm_elem; /* ksmd 의 stable/unstable 테이블 원소 */
+	uint64_t ksm_sum;		   /* 지난 스캔 때 내용의 checksum */
+	uint8_t ksm;			   /* KSM_NONE, KSM_UNSTABLE, KSM_STABLE (vm.c) */
+	struct hash_elem text_elem; /* 실행 파일 코드 페이지 테이블 원소 (FRAME_TEXT) */
+	struct inode *text_inode;	/* FRAME_TEXT 일 때 내용을 읽어 온 실행 파일과 */
+	off_t text_ofs;				/* 그 안의 위치 */
 };
 
+#define FRAME_USED 0x1	 /* 페이지에 쓰이고 있음. 아니면 palloc 의 빈 페이지 */
+#define FRAME_PINNED 0x2 /* 내용을 채우는 중. eviction, ksmd 대상에서 제외 */
+#define FRAME_TEXT 0x4	 /* 다른 프로세스도 찾아 쓰는 read-only 코드 페이지 */
+#define FRAME_COLD 0x8	 /* 순차 접근으로 지나간 페이지. 가장 먼저 쫓아낸다 */
+#define FRAME_EVICTING 0x10 /* 내용을 내보내는 중. 페이지를 쓰려면 끝날 때까지 기다린다 */
+#define FRAME_WRITEBACK 0x20 /* flushd, msync 가 파일에 되돌려 쓰는 중. 위와 같이 기다린다 */
+
+/* Frame eviction policy, selected at boot with "-evict=fifo|clock". */
+enum vm_evict_policy
+{
+	VM_EVICT_FIFO,	/* Evict the frame taken into use first. */
+	VM_EVICT_CLOCK, /* Second chance using the accessed bit. */
+};
+
+extern enum vm_evict_policy vm_evict_policy;
+
+/* Free user frame watermarks of the reclaim thread, in pages.
+ * Set at boot with "-reclaim-low=N" and "-reclaim-high=N". */
+extern int vm_reclaim_low;
+extern int vm_reclaim_high;
+
+/* Pages mapped per fault on a file-backed page, set at boot with
+ * "-fault-around=N" (at most VM_FAULT_AROUND_MAX; 1 turns it off). */
+#define VM_FAULT_AROUND_MAX 32
+extern int vm_fault_around;
+
+/* Same-page merging of anonymous frames, turned on at boot with
+ * "-ksm"; ksmd looks at "-ksm-rate=N" frames per pass. */
+extern bool vm_ksm;
+extern int vm_ksm_rate;
+
+/* Map 2 MiB aligned regions of fresh anonymous pages with one large
+ * page, turned on at boot with "-huge". */
+extern bool vm_huge;
+
+/* Soft limit on the resident pages of each process, set at boot with
+ * "-rss-limit=N" (0, the default, means no limit). A process at its
+ * limit replaces its own pages on a fault. "-rss-stats" prints each
+ * process's paging counters when it exits. */
+extern int vm_rss_limit;
+extern bool vm_rss_stats;
+
+/* Dirty mmap pages the writeback thread writes per pass, set at boot
+ * with "-flush-rate=N" (0 turns the thread off). */
+extern int vm_flush_rate;
+
+/* Page-fault frequency window in timer ticks, and the number of faults
+ * per window below which a process counts as not needing more frames. */
+#define VM_PFF_WINDOW 100
+#define VM_PFF_LOW 4
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -97,13 +162,39 @@ struct page_operations
 	(page)->operations->destroy(page)
 
 /* Representation of current process's memory space.
- * We don't want to force you to obey any specific design for this struct.
- * All designs up to you for this. */
+ * A radix tree keyed by virtual page number, laid out like the pml4:
+ * SPT_LEVELS levels of 512 slots, one kernel page per node. The leaf
+ * slots hold the struct page of each user page. The mmap regions and
+ * executable segments are kept next to it as struct vma (vm/vma.h);
+ * their pages are only put into the tree on first fault. */
+#define SPT_LEVELS 4
+#define SPT_BITS 9
+struct spt_node;
 struct supplemental_page_table
 {
-	struct hash spt_hash;
+	struct spt_node *root; /* 아직 페이지가 하나도 없으면 NULL */
+	size_t page_cnt;
+	struct list vmas; /* struct vma, start 순서 */
+
+	/* Paging counters of the process, kept under frame_lock (rss) or
+	 * by the faulting thread itself (the rest). */
+	size_t rss;			 /* 프레임이 연결된 페이지 수 (resident set) */
+	size_t rss_max;		 /* rss 의 최댓값 */
+	long long fault_cnt; /* 이 프로세스의 page fault 수 */
+	long long evict_cnt; /* 이 프로세스의 페이지가 쫓겨난 수 */
+	int64_t pff_start;	 /* 지금 PFF 구간이 시작된 tick */
+	int pff_cur;		 /* 지금 구간의 fault 수 */
+	int pff_last;		 /* 바로 전 구간의 fault 수 */
+	int prefetch_cnt;	 /* prefetchd 에 걸려 있는 madvise(WILLNEED) 요청 수 */
+	int ra_window;		 /* swap readahead 로 한 번에 읽는 페이지 수 (anon.c) */
+	void *ra_next_va;	 /* 순차 접근이면 다음 swap-in fault 가 날 곳 */
 };
 
+/* Called by spt_for_each() for each page. Returning false stops the
+ * walk. It may remove the page, but must not insert into the same
+ * table. */
+typedef bool spt_action_func(struct page *page, void *aux);
+
 #include "threads/thread.h"
 void supplemental_page_table_init(struct supplemental_page_table *spt);
 bool supplemental_page_table_copy(struct supplemental_page_table *dst,
@@ -113,8 +204,19 @@ struct page *spt_find_page(struct supplemental_page_table *spt,
 						   void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux);
 
 void vm_init(void);
+void vm_print_stats(void);
+void vm_print_proc_stats(struct thread *t);
+bool vm_set_evict_policy(const char *name);
+void vm_put_frame(struct page *page);
+struct frame *vm_alloc_frame(const struct supplemental_page_table *spt);
+void vm_swap_cache_add(struct page *page, struct frame *frame);
+bool vm_sync_page(struct page *page);
+void vm_prefetch(struct supplemental_page_table *spt, void *start, void *end);
+void vm_prefetch_cancel(struct supplemental_page_table *spt);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
 						 bool write, bool not_present);
 
@@ -0,0 +1,57 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "vm/vm.h"
+
+/* A virtual memory area: one mmap() region or one executable segment.
+ * The struct pages of the region are not made up front; the first
+ * fault on an address inside it creates the page from the region
+ * (vma_get_page()). mmap regions are VM_FILE. Executable segments
+ * carry VM_SEGMENT: writable ones load into VM_ANON pages, read-only
+ * ones are VM_FILE pages, which eviction drops since the executable
+ * still has the same bytes. */
+#define VM_SEGMENT VM_MARKER_1
+
+/* Access pattern hints of madvise(). The values are those of the
+ * MADV_* constants in lib/user/syscall.h. WILLNEED and DONTNEED act
+ * on the pages right away; the others are kept in the region. */
+enum vma_advice
+{
+	VMA_NORMAL,		/* 기본. fault-around 는 vm_fault_around 페이지 */
+	VMA_RANDOM,		/* fault-around 를 하지 않는다 */
+	VMA_SEQUENTIAL, /* 최대한 앞서 읽고, 지나간 페이지는 먼저 쫓아낸다 */
+	VMA_WILLNEED,	/* 곧 쓸 페이지. 백그라운드에서 미리 읽는다 */
+	VMA_DONTNEED,	/* 더는 안 쓸 페이지. 프레임과 스왑 자리를 바로 돌려준다 */
+};
+
+struct vma
+{
+	uint8_t *start;	   /* 첫 페이지. 페이지 정렬 */
+	uint8_t *end;	   /* 마지막 페이지의 다음 주소 */
+	struct file *file; /* file_reopen() 한 이 영역만의 핸들. 영역과 같이 닫힌다 */
+	off_t ofs;		   /* START 에 올라오는 파일 위치 */
+	size_t read_bytes; /* START 부터 파일에서 읽는 바이트 수. 나머지는 0 */
+	bool writable;
+	enum vm_type type; /* VM_ANON 또는 VM_FILE, 세그먼트면 | VM_SEGMENT */
+	enum vma_advice advice; /* VMA_NORMAL, VMA_RANDOM, VMA_SEQUENTIAL */
+	struct list_elem elem; /* spt->vmas, start 순서 */
+};
+
+struct vma *vma_add(struct supplemental_page_table *spt, void *start, size_t size,
+					struct file *file, off_t ofs, size_t read_bytes,
+					bool writable, enum vm_type type);
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va);
+bool vma_range_free(struct supplemental_page_table *spt, const void *start, size_t size);
+off_t vma_page_ofs(const struct vma *vma, const void *va);
+size_t vma_page_read_bytes(const struct vma *vma, const void *va);
+struct page *vma_get_page(struct supplemental_page_table *spt, void *va);
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma);
+void vma_free_all(struct supplemental_page_table *spt);
+int vma_advise(struct supplemental_page_table *spt, void *addr, size_t length,
+			   int advice);
+
+#endif /* vm/vma.h */
@@ -0,0 +1,25 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+
+struct page;
+
+/* Writes a page pushed out of the full pool, already decompressed
+ * into KVA, to a new swap slot and returns the slot, or -1 if there is
+ * no room. Called without zswap's lock. */
+typedef int zswap_writeback_func(const void *kva);
+/* Frees SLOT, written by a zswap_writeback_func for a page that was
+ * loaded or dropped while the write was going on. */
+typedef void zswap_slot_free_func(int slot);
+
+/* Pool size in kernel pages, set at boot with "-zswap=N" (0 turns
+ * the compressed tier off). -1 means a quarter of the user pool. */
+extern int vm_zswap_pages;
+
+void zswap_init(zswap_writeback_func *writeback, zswap_slot_free_func *slot_free);
+bool zswap_store(struct page *page, const void *kva);
+bool zswap_load(struct page *page, void *kva);
+bool zswap_invalidate(struct page *page);
+void zswap_print_stats(void);
+
+#endif
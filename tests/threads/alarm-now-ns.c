@@ -0,0 +1,47 @@
+/* Tests timer_now_ns(): it never goes backward, has sub-tick
+   resolution, and agrees with timer_sleep() and timer_usleep(). */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define NS_PER_TICK (1000000000 / TIMER_FREQ)
+
+void
+test_alarm_now_ns (void) 
+{
+  uint64_t prev, now, start;
+  int i, steps = 0;
+
+  /* Back-to-back reads go forward in small steps, not whole ticks. */
+  prev = timer_now_ns ();
+  for (i = 0; i < 10000; i++)
+    {
+      now = timer_now_ns ();
+      if (now < prev)
+        fail ("timer_now_ns() went back from %"PRIu64" to %"PRIu64, prev, now);
+      if (now != prev && now - prev < NS_PER_TICK)
+        steps++;
+      prev = now;
+    }
+  msg ("timer_now_ns() is monotonic");
+  if (steps == 0)
+    fail ("timer_now_ns() only moves a tick at a time");
+  msg ("timer_now_ns() has sub-tick resolution");
+
+  start = timer_now_ns ();
+  timer_sleep (5);
+  now = timer_now_ns ();
+  if (now - start < 4 * NS_PER_TICK)
+    fail ("timer_sleep (5) took only %"PRIu64" ns", now - start);
+  msg ("timer_sleep (5) took at least 4 ticks");
+
+  start = timer_now_ns ();
+  timer_usleep (100);
+  now = timer_now_ns ();
+  if (now - start < 90000)
+    fail ("timer_usleep (100) took only %"PRIu64" ns", now - start);
+  msg ("timer_usleep (100) took at least 90 us");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-now-ns) begin
+(alarm-now-ns) timer_now_ns() is monotonic
+(alarm-now-ns) timer_now_ns() has sub-tick resolution
+(alarm-now-ns) timer_sleep (5) took at least 4 ticks
+(alarm-now-ns) timer_usleep (100) took at least 90 us
+(alarm-now-ns) end
+EOF
+pass;
@@ -0,0 +1,78 @@
+/* Tests sema_down_timeout() and cond_wait_timeout(): a wait that
+   nobody ends must time out after its ticks and no earlier, and a
+   wait that is ended in time must return success well before its
+   timeout. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func sema_upper;
+static thread_func cond_signaler;
+
+static struct semaphore sema;
+static struct lock lock;
+static struct condition cond;
+
+void
+test_alarm_timeout (void) 
+{
+  int64_t start;
+  bool ok;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  start = timer_ticks ();
+  ok = sema_down_timeout (&sema, 10);
+  msg ("sema_down_timeout with no sema_up: %s", ok ? "acquired" : "timed out");
+  if (timer_elapsed (start) < 10)
+    fail ("timed out after %"PRId64" ticks, before 10", timer_elapsed (start));
+
+  thread_create ("sema-upper", PRI_DEFAULT, sema_upper, NULL);
+  start = timer_ticks ();
+  ok = sema_down_timeout (&sema, 1000);
+  msg ("sema_down_timeout with sema_up: %s", ok ? "acquired" : "timed out");
+  if (timer_elapsed (start) >= 1000)
+    fail ("waited %"PRId64" ticks for sema_up", timer_elapsed (start));
+
+  lock_init (&lock);
+  cond_init (&cond);
+  lock_acquire (&lock);
+  start = timer_ticks ();
+  ok = cond_wait_timeout (&cond, &lock, 10);
+  msg ("cond_wait_timeout with no signal: %s", ok ? "signaled" : "timed out");
+  if (timer_elapsed (start) < 10)
+    fail ("timed out after %"PRId64" ticks, before 10", timer_elapsed (start));
+  if (!lock_held_by_current_thread (&lock))
+    fail ("lock not reacquired after timeout");
+
+  thread_create ("cond-signaler", PRI_DEFAULT, cond_signaler, NULL);
+  start = timer_ticks ();
+  ok = cond_wait_timeout (&cond, &lock, 1000);
+  msg ("cond_wait_timeout with signal: %s", ok ? "signaled" : "timed out");
+  if (timer_elapsed (start) >= 1000)
+    fail ("waited %"PRId64" ticks for cond_signal", timer_elapsed (start));
+  lock_release (&lock);
+}
+
+static void
+sema_upper (void *aux UNUSED) 
+{
+  timer_sleep (5);
+  sema_up (&sema);
+}
+
+static void
+cond_signaler (void *aux UNUSED) 
+{
+  timer_sleep (5);
+  lock_acquire (&lock);
+  cond_signal (&cond, &lock);
+  lock_release (&lock);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-timeout) begin
+(alarm-timeout) sema_down_timeout with no sema_up: timed out
+(alarm-timeout) sema_down_timeout with sema_up: acquired
+(alarm-timeout) cond_wait_timeout with no signal: timed out
+(alarm-timeout) cond_wait_timeout with signal: signaled
+(alarm-timeout) end
+EOF
+pass;
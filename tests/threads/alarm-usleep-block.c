@@ -0,0 +1,56 @@
+/* Checks that a sub-tick timer_usleep() blocks on the local APIC
+   timer (run with "-lapic-timer") instead of spinning: a thread of
+   lower priority, which only runs while the main thread is off the
+   CPU, must get to run during the sleeps. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 10
+#define SLEEP_US 500
+
+static thread_func counter_thread;
+static volatile int64_t count;
+static volatile bool done;
+
+void
+test_alarm_usleep_block (void)
+{
+  uint64_t start, now;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (!timer_lapic)
+    fail ("LAPIC timer is not in use");
+
+  thread_create ("counter", PRI_MIN, counter_thread, NULL);
+
+  start = timer_now_ns ();
+  for (i = 0; i < SLEEP_CNT; i++)
+    timer_usleep (SLEEP_US);
+  now = timer_now_ns ();
+  if (now - start < SLEEP_CNT * (SLEEP_US - 50) * 1000ULL)
+    fail ("%d sleeps of %d us took only %"PRIu64" ns",
+          SLEEP_CNT, SLEEP_US, now - start);
+  msg ("%d sleeps of %d us took long enough", SLEEP_CNT, SLEEP_US);
+
+  if (count == 0)
+    fail ("lower priority thread never ran: timer_usleep() spun");
+  msg ("lower priority thread ran during the sleeps");
+
+  /* Let the counter thread see DONE and exit. */
+  done = true;
+  timer_sleep (1);
+}
+
+static void
+counter_thread (void *aux UNUSED)
+{
+  while (!done)
+    count++;
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-usleep-block) begin
+(alarm-usleep-block) 10 sleeps of 500 us took long enough
+(alarm-usleep-block) lower priority thread ran during the sleeps
+(alarm-usleep-block) end
+EOF
+pass;
@@ -0,0 +1,79 @@
+/* Measures the cost of a context switch with few and with many
+   threads ready at the same priority.  Each thread only yields, so
+   every switch puts one thread at the back of the run queue and
+   takes the next one from the front.  With one run queue per
+   priority both take constant time, and the cycles per switch
+   should stay about the same as the number of ready threads grows
+   from SMALL_CNT to LARGE_CNT. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define SMALL_CNT 64
+#define LARGE_CNT 2048
+#define ROUND_CNT 16
+
+static thread_func yield_thread_func;
+static void measure (int thread_cnt);
+
+static volatile bool stop;
+static struct semaphore done;
+
+void
+test_priority_sched_bench (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  sema_init (&done, 0);
+  measure (SMALL_CNT);
+  measure (LARGE_CNT);
+}
+
+/* Runs THREAD_CNT yielding threads next to this one and reports the
+   average cycles per context switch over ROUND_CNT rounds. */
+static void
+measure (int thread_cnt) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  stop = false;
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[32];
+      snprintf (name, sizeof name, "yield %d", i);
+      if (thread_create (name, PRI_DEFAULT, yield_thread_func, NULL) == TID_ERROR)
+        fail ("creating thread %d of %d failed", i, thread_cnt);
+    }
+  msg ("%d threads ready", thread_cnt);
+
+  /* Let every thread start, then time whole rounds: each of our
+     yields runs every other thread once. */
+  thread_yield ();
+  start = rdtsc ();
+  for (i = 0; i < ROUND_CNT; i++)
+    thread_yield ();
+  cycles = rdtsc () - start;
+  msg ("%d threads: %llu cycles per switch", thread_cnt,
+       cycles / ((uint64_t) ROUND_CNT * (thread_cnt + 1)));
+
+  stop = true;
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&done);
+}
+
+static void
+yield_thread_func (void *aux UNUSED) 
+{
+  while (!stop)
+    thread_yield ();
+  sema_up (&done);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+
+# Cycle counts differ from run to run, so those lines are not compared.
+my (@output) = grep (!/cycles per switch$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", \@output, [<<'EOF']);
+(priority-sched-bench) begin
+(priority-sched-bench) 64 threads ready
+(priority-sched-bench) 2048 threads ready
+(priority-sched-bench) end
+EOF
+pass;
@@ -0,0 +1,85 @@
+/* Measures the cost of fork() with a small and with a large resident
+   data segment.  With copy-on-write each fork only has to share the
+   parent's frames, so the cycles per fork grow with the number of
+   resident pages only by the cost of linking and write-protecting
+   them, not by copying 4 kB for each. */
+
+#include <string.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/large.inc"
+
+#define FORK_CNT 8
+#define PAGE_SIZE 4096
+#define SMALL_PAGES 16
+
+static inline uint64_t
+rdtsc (void)
+{
+	uint32_t lo, hi;
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+/* Reads the first PAGE_CNT pages of LARGE, which makes them resident,
+   and returns their first bytes added up. */
+static size_t
+sum_pages (size_t page_cnt)
+{
+	size_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < page_cnt && i * PAGE_SIZE < sizeof large; i++)
+		sum += large[i * PAGE_SIZE];
+	return sum;
+}
+
+/* Forks FORK_CNT children with the first PAGE_CNT pages of LARGE
+   resident and reports the average cycles fork() took in the parent.
+   Each child checks that it sees the parent's data, then writes one
+   page, which copies only that page.  Returns the parent's sum of
+   those pages. */
+static size_t
+measure (size_t page_cnt)
+{
+	size_t expected = sum_pages (page_cnt);
+	uint64_t cycles = 0;
+	int i;
+
+	msg ("fork %d children", FORK_CNT);
+	for (i = 0; i < FORK_CNT; i++) {
+		uint64_t start = rdtsc ();
+		pid_t child = fork ("child");
+
+		if (child == 0) {
+			if (sum_pages (page_cnt) != expected)
+				exit (1);
+			large[0] = '@';
+			exit (large[0] == '@' ? 0 : 1);
+		}
+		cycles += rdtsc () - start;
+		if (child < 0)
+			fail ("fork #%d failed", i);
+		if (wait (child) != 0)
+			fail ("child #%d saw wrong data", i);
+	}
+	msg ("%zu resident pages: %llu cycles per fork", page_cnt,
+	     (unsigned long long) (cycles / FORK_CNT));
+	return expected;
+}
+
+void
+test_main (void)
+{
+	size_t all = (sizeof large + PAGE_SIZE - 1) / PAGE_SIZE;
+	size_t expected;
+
+	measure (SMALL_PAGES);
+	expected = measure (all);
+	msg ("all children saw the parent's data");
+
+	CHECK (sum_pages (all) == expected, "parent's data unchanged");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+
+# Cycle counts differ from run to run, so those lines are not compared.
+my (@output) = grep (!/cycles per fork$/, read_text_file ("$test.output"));
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(cow-fork-bench) begin
+(cow-fork-bench) fork 8 children
+(cow-fork-bench) fork 8 children
+(cow-fork-bench) all children saw the parent's data
+(cow-fork-bench) parent's data unchanged
+(cow-fork-bench) end
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Reads the page fault statistics through int 0x45 and checks that
+   first touches of a fresh anonymous page and of an mmap'd file page
+   are counted under their causes, and that the latency histogram of
+   each cause adds up to its fault count. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define PAGE_SIZE 4096
+
+static char zeros[PAGE_SIZE * 3];
+
+static long long
+hist_sum (int cause)
+{
+  long long sum = 0;
+  int b;
+
+  for (b = 0; b < FAULT_HIST_BUCKETS; b++)
+    sum += get_page_fault_stat (cause, b);
+  return sum;
+}
+
+void
+test_main (void)
+{
+  char *page = (char *) (((unsigned long) zeros + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+  long long before;
+  int handle;
+  int cause;
+
+  before = get_page_fault_stat (FAULT_ZERO, FAULT_HIST_BUCKETS);
+  page[0] = 1;
+  CHECK (get_page_fault_stat (FAULT_ZERO, FAULT_HIST_BUCKETS) > before,
+         "zero-fill fault counted");
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (ACTUAL, 4096, 0, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  before = get_page_fault_stat (FAULT_UNINIT, FAULT_HIST_BUCKETS);
+  CHECK (!memcmp (ACTUAL, sample, strlen (sample)), "read of mmap'd page");
+  CHECK (get_page_fault_stat (FAULT_UNINIT, FAULT_HIST_BUCKETS) > before,
+         "lazy-load fault counted");
+
+  for (cause = FAULT_UNINIT; cause <= FAULT_BAD; cause++)
+    if (hist_sum (cause) != get_page_fault_stat (cause, FAULT_HIST_BUCKETS))
+      fail ("histogram of cause %d does not add up", cause);
+  msg ("histograms add up");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(fault-stats) begin
+(fault-stats) zero-fill fault counted
+(fault-stats) create "sample.txt"
+(fault-stats) open "sample.txt"
+(fault-stats) mmap "sample.txt"
+(fault-stats) read of mmap'd page
+(fault-stats) lazy-load fault counted
+(fault-stats) histograms add up
+(fault-stats) end
+EOF
+pass;
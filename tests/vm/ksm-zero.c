@@ -0,0 +1,63 @@
+/* Fills a few pages of the BSS with data, zeroes them again and
+   checks that ksmd (run with "-ksm") merges them into the zero page:
+   their physical address becomes that of a page that was only ever
+   read.  A write afterwards must give the page a frame of its own
+   again without disturbing the others. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 8
+#define MAX_TRIES 1000000
+
+static char buf[(PAGE_CNT + 2) * PAGE_SIZE];
+
+static bool
+all_merged (char *pages, void *zero_pa)
+{
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (get_phys_addr (pages + i * PAGE_SIZE) != zero_pa)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  char *pages = (char *) (((unsigned long) buf + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+  char *probe = pages + PAGE_CNT * PAGE_SIZE;
+  void *zero_pa;
+  int i, try;
+
+  /* A page that is only read is mapped to the zero page. */
+  CHECK (probe[0] == 0, "read untouched page");
+  zero_pa = get_phys_addr (probe);
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      memset (pages + i * PAGE_SIZE, 'a' + i, PAGE_SIZE);
+      memset (pages + i * PAGE_SIZE, 0, PAGE_SIZE);
+    }
+  msg ("zeroed %d written pages", PAGE_CNT);
+
+  for (try = 0; try < MAX_TRIES && !all_merged (pages, zero_pa); try++)
+    continue;
+  if (try == MAX_TRIES)
+    fail ("zero-filled pages were not merged");
+  msg ("zero-filled pages merged into the zero page");
+
+  pages[0] = 'x';
+  CHECK (get_phys_addr (pages) != zero_pa, "write gets a frame of its own");
+  for (i = 1; i < PAGE_SIZE; i++)
+    if (pages[i] != 0)
+      fail ("byte %d of the written page is %d", i, pages[i]);
+  for (i = PAGE_SIZE; i < PAGE_CNT * PAGE_SIZE; i++)
+    if (pages[i] != 0)
+      fail ("byte %d of a merged page is %d", i, pages[i]);
+  CHECK (pages[0] == 'x' && probe[0] == 0, "other pages still zero");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(ksm-zero) begin
+(ksm-zero) read untouched page
+(ksm-zero) zeroed 8 written pages
+(ksm-zero) zero-filled pages merged into the zero page
+(ksm-zero) write gets a frame of its own
+(ksm-zero) other pages still zero
+(ksm-zero) end
+EOF
+pass;
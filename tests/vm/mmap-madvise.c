@@ -0,0 +1,56 @@
+/* Gives every madvise() hint to a file mapping and checks that the
+   data seen through it and through read() stays right, that
+   MADV_DONTNEED on a data segment page brings back its initial
+   contents, and that bad calls fail. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define PAGE_SIZE 4096
+
+static char data[PAGE_SIZE * 3];
+
+void
+test_main (void)
+{
+  int handle;
+  void *map;
+  char buf[1024];
+  char *page = (char *) (((unsigned long) data + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+  size_t i;
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED, "mmap \"sample.txt\"");
+  CHECK (madvise (map, 4096, MADV_SEQUENTIAL) == 0, "madvise sequential");
+  CHECK (madvise (map, 4096, MADV_RANDOM) == 0, "madvise random");
+  CHECK (madvise (map, 4096, MADV_WILLNEED) == 0, "madvise willneed");
+  memcpy (ACTUAL, sample, strlen (sample));
+
+  /* Dropping a dirty file page writes it back first. */
+  CHECK (madvise (map, 4096, MADV_DONTNEED) == 0, "madvise dontneed");
+  CHECK (!memcmp (ACTUAL, sample, strlen (sample)),
+         "compare mapped data against written data");
+  read (handle, buf, strlen (sample));
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare read data against written data");
+
+  /* A dropped data segment page reads as first loaded. */
+  memset (page, 'x', PAGE_SIZE);
+  CHECK (madvise (page, PAGE_SIZE, MADV_DONTNEED) == 0, "madvise dontneed data page");
+  for (i = 0; i < PAGE_SIZE; i++)
+    if (page[i] != 0)
+      fail ("byte %zu of dropped page is %d", i, page[i]);
+
+  CHECK (madvise ((char *) ACTUAL + 1, 4096, MADV_NORMAL) == -1,
+         "madvise misaligned address must fail");
+  CHECK (madvise ((char *) ACTUAL + 0x100000, 4096, MADV_NORMAL) == -1,
+         "madvise unmapped address must fail");
+  CHECK (madvise (map, 4096, 99) == -1, "madvise bad advice must fail");
+  munmap (map);
+  close (handle);
+}
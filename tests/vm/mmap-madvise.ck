@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) create "sample.txt"
+(mmap-madvise) open "sample.txt"
+(mmap-madvise) mmap "sample.txt"
+(mmap-madvise) madvise sequential
+(mmap-madvise) madvise random
+(mmap-madvise) madvise willneed
+(mmap-madvise) madvise dontneed
+(mmap-madvise) compare mapped data against written data
+(mmap-madvise) compare read data against written data
+(mmap-madvise) madvise dontneed data page
+(mmap-madvise) madvise misaligned address must fail
+(mmap-madvise) madvise unmapped address must fail
+(mmap-madvise) madvise bad advice must fail
+(mmap-madvise) end
+EOF
+pass;
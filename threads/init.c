@@ -31,6 +31,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -152,15 +153,27 @@ paging_init (uint64_t mem_end) {
 	extern char start, _end_kernel_text;
 	// Maps physical address [0 ~ mem_end] to
 	//   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	// Whole 2 MiB chunks that do not overlap the read-only kernel text
+	// are mapped with one large page each; the rest page by page.
+	for (uint64_t pa = 0; pa < mem_end; ) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		if (pa % LARGE_PGSIZE == 0 && pa + LARGE_PGSIZE <= mem_end
+				&& (va + LARGE_PGSIZE <= (uint64_t) &start
+					|| va >= (uint64_t) &_end_kernel_text)) {
+			if ((pte = pml4e_walk_pde (pml4, va, 1)) != NULL)
+				*pte = pa | PTE_P | PTE_W | PTE_PS;
+			pa += LARGE_PGSIZE;
+			continue;
+		}
+
 		perm = PTE_P | PTE_W;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
 
 		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
 			*pte = pa | perm;
+		pa += PGSIZE;
 	}
 
 	// reload cr3
@@ -221,11 +234,41 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-lapic-timer"))
+			timer_lapic = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-evict")) {
+			if (!vm_set_evict_policy (value))
+				PANIC ("unknown eviction policy `%s' (use fifo or clock)", value);
+		}
+		else if (!strcmp (name, "-reclaim-low"))
+			vm_reclaim_low = atoi (value);
+		else if (!strcmp (name, "-reclaim-high"))
+			vm_reclaim_high = atoi (value);
+		else if (!strcmp (name, "-fault-around"))
+			vm_fault_around = atoi (value);
+		else if (!strcmp (name, "-ksm"))
+			vm_ksm = true;
+		else if (!strcmp (name, "-ksm-rate"))
+			vm_ksm_rate = atoi (value);
+		else if (!strcmp (name, "-zswap"))
+			vm_zswap_pages = atoi (value);
+		else if (!strcmp (name, "-huge"))
+			vm_huge = true;
+		else if (!strcmp (name, "-rss-limit"))
+			vm_rss_limit = atoi (value);
+		else if (!strcmp (name, "-rss-stats"))
+			vm_rss_stats = true;
+		else if (!strcmp (name, "-flush-rate"))
+			vm_flush_rate = atoi (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +369,23 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -tickless          Stop the timer tick while the CPU is idle.\n"
+			"  -lapic-timer       Block in sub-tick sleeps on the local APIC timer.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -evict=POLICY      Evict frames by POLICY: fifo or clock (default).\n"
+			"  -reclaim-low=N     Start background reclaim below N free user pages.\n"
+			"  -reclaim-high=N    Stop background reclaim at N free user pages.\n"
+			"  -fault-around=N    Map up to N file pages per fault (1 = off).\n"
+			"  -ksm               Merge identical anonymous pages in the background.\n"
+			"  -ksm-rate=N        Let the merging thread scan N frames per pass.\n"
+			"  -zswap=N           Keep up to N kernel pages of compressed swap (0 = off).\n"
+			"  -huge              Map 2 MiB aligned anonymous regions with large pages.\n"
+			"  -rss-limit=N       Keep each process to about N resident pages (0 = off).\n"
+			"  -rss-stats         Print each process's paging counters at exit.\n"
+			"  -flush-rate=N      Write back up to N dirty mmap pages per pass (0 = off).\n"
 #endif
 			);
 	power_off ();
@@ -362,4 +420,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
@@ -8,6 +8,32 @@
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+long long pml4_split_cnt;
+
+/* Replaces the 2 MiB mapping in *PDE, which covers VA, with a page
+ * table of 4 KiB PTEs that map the same memory with the same flags,
+ * so that one of them can be changed on its own.
+ * Returns false if no page could be allocated for the page table. */
+static bool
+pde_split (uint64_t *pde, const uint64_t va) {
+	uint64_t *pt = palloc_get_page (0);
+	uint64_t pa = PTE_ADDR (*pde) & ~(LARGE_PGSIZE - 1);
+	uint64_t flags = *pde & PTE_FLAGS & ~PTE_PS;
+
+	if (pt == NULL)
+		return false;
+	for (unsigned i = 0; i < LARGE_PGCNT; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	// 이 주소 공간이 지금 쓰이고 있지 않아도 invlpg 는 해가 없다.
+	invlpg ((uint64_t) large_pg_round_down (va));
+	pml4_split_cnt++;
+	return true;
+}
+
+/* If VA is mapped by a 2 MiB page, returns its page directory entry
+ * when CREATE is false, and splits it into 4 KiB pages first when
+ * CREATE is true, since the caller is about to change one of them. */
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
@@ -23,6 +49,12 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 			} else
 				return NULL;
 		}
+		if (pdp[idx] & PTE_PS) {
+			if (!create)
+				return &pdp[idx];
+			if (!pde_split (&pdp[idx], va))
+				return NULL;
+		}
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
 	return NULL;
@@ -94,6 +126,29 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the table ENTRY points to, allocating it if ENTRY is not
+ * present and CREATE is true. */
+static uint64_t *
+next_level (uint64_t *entry, int create) {
+	if (!(*entry & PTE_P)) {
+		uint64_t *new_page;
+		if (!create || (new_page = palloc_get_page (PAL_ZERO)) == NULL)
+			return NULL;
+		*entry = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+	}
+	return ptov (PTE_ADDR (*entry));
+}
+
+/* Returns the address of the page directory entry for VA, the level
+ * that maps a 2 MiB page when PTE_PS is set in it. Missing upper
+ * levels are created if CREATE is true. */
+uint64_t *
+pml4e_walk_pde (uint64_t *pml4e, const uint64_t va, int create) {
+	uint64_t *pdpe = next_level (&pml4e[PML4 (va)], create);
+	uint64_t *pde = pdpe != NULL ? next_level (&pdpe[PDPE (va)], create) : NULL;
+	return pde != NULL ? &pde[PDX (va)] : NULL;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -130,10 +185,17 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
-					pml4_index, pdp_index, i))
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
 				return false;
+		} else if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
+					pml4_index, pdp_index, i))
+			return false;
 	}
 	return true;
 }
@@ -179,7 +241,12 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (pdp[i] & PTE_PS)
+			palloc_free_multiple (ptov (PTE_ADDR (pdp[i]) & ~(LARGE_PGSIZE - 1)),
+					LARGE_PGCNT);
+		else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -228,6 +295,8 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	// 해당 페이지 가상주소
+	if (pte && (*pte & PTE_P) && (*pte & PTE_PS))
+		return ptov (PTE_ADDR (*pte) & ~(LARGE_PGSIZE - 1)) + large_pg_ofs (uaddr);
 	if (pte && (*pte & PTE_P))
 		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
 	return NULL;
@@ -255,6 +324,37 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* Maps the 2 MiB user region at UPAGE to the physically contiguous
+ * pages at KPAGE with a single page directory entry. Both must be
+ * 2 MiB aligned, KPAGE physically. Nothing in the region may be
+ * mapped; an empty page table left there is freed.
+ * Returns false if memory allocation failed or part of the region
+ * is still mapped. */
+bool
+pml4_set_large_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	uint64_t *pde;
+
+	ASSERT (large_pg_ofs (upage) == 0);
+	ASSERT (large_pg_ofs (vtop (kpage)) == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	pde = pml4e_walk_pde (pml4, (uint64_t) upage, 1);
+	if (pde == NULL)
+		return false;
+	if ((*pde & PTE_P) && !(*pde & PTE_PS)) {
+		uint64_t *pt = ptov (PTE_ADDR (*pde));
+		for (unsigned i = 0; i < LARGE_PGCNT; i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page (pt);
+	}
+	*pde = vtop (kpage) | PTE_P | PTE_PS | (rw ? PTE_W : 0) | PTE_U;
+	if (rcr3 () == vtop (pml4))
+		invlpg ((uint64_t) upage);
+	return true;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -267,6 +367,17 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 
 	pte = pml4e_walk (pml4, (uint64_t) upage, false);
 
+	// 2 MiB 페이지의 일부만 지우므로 4 KiB 로 쪼갠 뒤 지운다. 쪼갤 메모리가
+	// 없으면 통째로 내린다. 나머지 페이지는 다음 fault 때 다시 매핑된다.
+	if (pte != NULL && (*pte & PTE_P) && (*pte & PTE_PS)) {
+		uint64_t *pde = pte;
+		if ((pte = pml4e_walk (pml4, (uint64_t) upage, true)) == NULL) {
+			*pde &= ~PTE_P;
+			invlpg ((uint64_t) upage);
+			return;
+		}
+	}
+
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
 		if (rcr3 () == vtop (pml4))
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -31,6 +32,8 @@ struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	size_t usable_cnt;              /* Number of usable pages. */
+	size_t free_cnt;                /* Number of free pages. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +45,7 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void pool_adjust_free_cnt (struct pool *, long delta);
 
 /* multiboot info */
 struct multiboot_info {
@@ -224,14 +228,18 @@ split:
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool->usable_cnt += page_cnt;
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
 				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool->usable_cnt += page_cnt;
 			}
 		}
 	}
+	kernel_pool.free_cnt = kernel_pool.usable_cnt;
+	user_pool.free_cnt = user_pool.usable_cnt;
 }
 
 /* Initializes the page allocator and get the memory size */
@@ -265,6 +273,8 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 
 	lock_acquire (&pool->lock);
 	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	if (page_idx != BITMAP_ERROR)
+		pool_adjust_free_cnt (pool, -(long) page_cnt);
 	lock_release (&pool->lock);
 	void *pages;
 
@@ -284,6 +294,35 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the physical address of the first
+   page is a multiple of ALIGN_CNT pages, as a 2 MiB large page
+   mapping needs. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt, size_t align_cnt) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t first = (align_cnt - vtop (pool->base) / PGSIZE % align_cnt) % align_cnt;
+	size_t page_idx = BITMAP_ERROR;
+	void *pages = NULL;
+
+	lock_acquire (&pool->lock);
+	for (size_t i = first; i + page_cnt <= bitmap_size (pool->used_map); i += align_cnt)
+		if (bitmap_none (pool->used_map, i, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, i, page_cnt, true);
+			pool_adjust_free_cnt (pool, -(long) page_cnt);
+			page_idx = i;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	if (page_idx != BITMAP_ERROR) {
+		pages = pool->base + PGSIZE * page_idx;
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else if (flags & PAL_ASSERT)
+		PANIC ("palloc_get: out of pages");
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -322,6 +361,7 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #endif
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
 	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_adjust_free_cnt (pool, page_cnt);
 }
 
 /* Frees the page at PAGE. */
@@ -330,6 +370,50 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of free pages in the user pool. */
+size_t
+palloc_user_free_cnt (void) {
+	return user_pool.free_cnt;
+}
+
+/* Returns the number of pages the user pool can hand out. */
+size_t
+palloc_user_page_cnt (void) {
+	return user_pool.usable_cnt;
+}
+
+/* Returns the number of pages the user pool spans, holes included.
+   Every user page has an index below this (palloc_user_index). */
+size_t
+palloc_user_span (void) {
+	return bitmap_size (user_pool.used_map);
+}
+
+/* Returns the index of user pool page PAGE, counted from the
+   start of the pool. */
+size_t
+palloc_user_index (const void *page) {
+	ASSERT (page_from_pool (&user_pool, (void *) page));
+	return pg_no (page) - pg_no (user_pool.base);
+}
+
+/* Returns the user pool page at index IDX. */
+void *
+palloc_user_page (size_t idx) {
+	ASSERT (idx < bitmap_size (user_pool.used_map));
+	return user_pool.base + idx * PGSIZE;
+}
+
+/* Adds DELTA to POOL's free page count.  Pages are freed without
+   the pool lock (even with interrupts off, from the scheduler),
+   so the update is done with interrupts disabled instead. */
+static void
+pool_adjust_free_cnt (struct pool *pool, long delta) {
+	enum intr_level old_level = intr_disable ();
+	pool->free_cnt += delta;
+	intr_set_level (old_level);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -340,6 +424,7 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
 
 	lock_init(&p->lock);
+	p->usable_cnt = p->free_cnt = 0;
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
 
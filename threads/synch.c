@@ -29,6 +29,7 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
@@ -91,6 +92,66 @@ sema_down (struct semaphore *sema) {
 	intr_set_level (old_level);
 }
 
+/* A thread waiting in sema_down_timeout(). */
+struct sema_timeout {
+	struct thread *thread;
+	bool timed_out;
+};
+
+/* timer event callback of sema_down_timeout(): takes the waiter off
+   the semaphore's list and wakes it, unless sema_up() already has. */
+static void
+sema_timeout_expire (void *w_) {
+	struct sema_timeout *w = w_;
+
+	w->timed_out = true;
+	if (w->thread->status == THREAD_BLOCKED) {
+		list_remove (&w->thread->elem);
+		thread_unblock (w->thread);
+		if (w->thread->priority > thread_current ()->priority)
+			intr_yield_on_return ();
+	}
+}
+
+/* Like sema_down(), but gives up after TICKS timer ticks. Returns
+   true if SEMA was decremented, false if the wait timed out. A
+   non-positive TICKS only tries, like sema_try_down(). The timeout
+   is a timer event, so waiting with one costs O(1) on top of
+   sema_down().
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks) {
+	struct sema_timeout w;
+	struct timer_event ev;
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	if (ticks <= 0)
+		return sema_try_down (sema);
+
+	w.thread = thread_current ();
+	w.timed_out = false;
+	timer_event_init (&ev, sema_timeout_expire, &w);
+	old_level = intr_disable ();
+	timer_event_add (&ev, timer_ticks () + ticks);
+	while (sema->value == 0 && !w.timed_out) {
+		list_insert_ordered (&sema->waiters, &w.thread->elem, cmp_priority, NULL);
+		thread_block ();
+	}
+	// 시간이 다 됐어도 sema_up() 이 먼저 깨웠다면 값을 가져간다.
+	success = sema->value > 0;
+	if (success)
+		sema->value--;
+	timer_event_cancel (&ev);
+	intr_set_level (old_level);
+	return success;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -335,6 +396,36 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	lock_acquire (lock);
 }
 
+/* Like cond_wait(), but gives up waiting after TICKS timer ticks.
+   LOCK is reacquired before returning either way. Returns true if
+   COND was signaled, false if the wait timed out.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+cond_wait_timeout (struct condition *cond, struct lock *lock, int64_t ticks) {
+	struct semaphore_elem waiter;
+	bool signaled;
+
+	ASSERT (cond != NULL);
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	sema_init (&waiter.semaphore, 0);
+	list_insert_ordered (&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+	lock_release (lock);
+	signaled = sema_down_timeout (&waiter.semaphore, ticks);
+	lock_acquire (lock);
+	/* cond_signal() 은 LOCK 을 잡고 waiter 를 빼면서 sema_up() 하므로,
+	   LOCK 을 다시 잡은 지금 세마포어가 올라가 있지 않으면 아직 목록에 있다. */
+	if (!signaled && !sema_try_down (&waiter.semaphore))
+		list_remove (&waiter.elem);
+	else
+		signaled = true;
+	return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -378,6 +469,9 @@ bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, voi
 	struct semaphore_elem *sema_b = list_entry(b, struct semaphore_elem, elem);
 	struct list *sema_a_waiters = &(sema_a->semaphore.waiters);
 	struct list *sema_b_waiters = &(sema_b->semaphore.waiters);
+	// cond_wait_timeout() 에서 시간이 다 된 waiter 는 LOCK 을 다시 잡을 때까지 빈 채로 남아 있다.
+	if (list_empty(sema_a_waiters) || list_empty(sema_b_waiters))
+		return !list_empty(sema_a_waiters) && list_empty(sema_b_waiters);
 	struct thread *sema_a_waiters_front = list_entry(list_begin(sema_a_waiters), struct thread, elem);
 	struct thread *sema_b_waiters_front = list_entry(list_begin(sema_b_waiters), struct thread, elem);
 	if (sema_a_waiters_front->priority > sema_b_waiters_front->priority)
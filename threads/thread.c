@@ -4,6 +4,7 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
@@ -39,17 +40,22 @@
 // #define RECENT_CPU_DEFAULT 0
 // #define LOAD_AVG_DEFAULT 0
 
-/* List of all process */
-static struct list all_list; // mlfqs 관련 변경
-
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* List of processes in THREAD_BLOCKED state, that is, processes
-   that are bloked and sleeping now */
-static struct list sleep_list; // alarm-multiple 관련 변경
-static int64_t next_tick_to_awake; /* alarm-multiple 관련 변경 */
+/* recent_cpu 의 초별 감쇠 계수 2*load_avg/(2*load_avg + 1) 기록 (mlfqs).
+   blocked 스레드는 매초 계산하지 않고, 깨어날 때 지나간 초의 계수를
+   한꺼번에 적용한다 (mlfqs_catch_up). */
+#define DECAY_HIST 256
+static int decay_hist[DECAY_HIST];
+static int64_t mlfqs_seconds;   /* mlfqs_recalc() 가 돈 횟수 */
+
+/* Run queues of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running: one FIFO list per
+   priority.  Bit P of ready_bitmap is set while ready_queues[P] is not
+   empty, so the highest ready priority is its most significant set
+   bit and picking the next thread does not depend on how many are
+   ready. */
+static struct list ready_queues[PRI_MAX - PRI_MIN + 1];
+static uint64_t ready_bitmap;
+static size_t ready_cnt;        /* # of threads in all ready_queues. */
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -86,6 +92,12 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static int ready_max_priority (void);
+static void change_priority (struct thread *, int priority);
+static int mlfqs_calc_priority (struct thread *);
+static void mlfqs_catch_up (struct thread *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -133,11 +145,11 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock); // 한번에 하나의 스레드만 생성할 수 있게 lock(세마포어에서의)을 건다. 임계영역에 스레드가 들어갔는데, 다른 스레드가 들어오지 못하게 lock
-	list_init (&ready_list); // ready queue 초기화
-	list_init (&all_list); // mlfqs 관련 변경
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++) // ready queue 초기화
+		list_init (&ready_queues[pri]);
+	ready_bitmap = 0;
+	ready_cnt = 0;
 	list_init (&destruction_req); // 파괴(kill) 요청이 들어온 스레드들을 모아두는 리스트 초기화
-	list_init (&sleep_list); // alarm-multiple 관련 변경 // initialize sleep_list
-	next_tick_to_awake = INT64_MAX; // alarm-multiple 관련 변경 // initialize next_tick_to_awake
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();				  // running상태의 thread 구조체의 주소를 반환
@@ -189,6 +201,14 @@ thread_tick (void) {
 		intr_yield_on_return ();
 }
 
+/* Counts a timer tick that passed while the idle thread was halted
+   in tickless mode (devices/timer.c). Called by the timer interrupt
+   handler, whichever thread it interrupted. */
+void
+thread_tick_idle (void) {
+	idle_ticks++;
+}
+
 /* Prints thread statistics. */
 void
 thread_print_stats (void) {
@@ -300,7 +320,9 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable (); // intr_disable return 값이 previous interrupt
 	ASSERT (t->status == THREAD_BLOCKED); // thread blocked 상태면 다음 줄로 넘어감
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL); // alarm-priority, priority-fifo/preempt 관련 변경 // instead Round-Robin scheduling, insert into ready_list base on priority.
+	if (thread_mlfqs)
+		mlfqs_catch_up (t); // mlfqs 관련 변경 // 자는 동안 건너뛴 recent_cpu 감쇠를 반영
+	ready_push (t); // alarm-priority, priority-fifo/preempt 관련 변경 // 자기 우선순위의 run queue 맨 뒤로. O(1)
 	t->status = THREAD_READY; // 상태를 ready로 바꾸고
 	intr_set_level (old_level);  // 이전 인터럽트 상태로 원상복귀 시켜준다.
 }
@@ -367,61 +389,40 @@ thread_yield (void) {
 
 	old_level = intr_disable (); // 인터럽트 비활
 	if (curr != idle_thread) // idle thread면 ready 중인 스레드가 없다
-		list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL); // alarm-priority, priority-fifo/preempt 관련 변경 // instead Round-Robin scheduling, insert into ready_list base on priority.
+		ready_push (curr); // alarm-priority, priority-fifo/preempt 관련 변경 // 같은 우선순위끼리는 round-robin
 	do_schedule (THREAD_READY); //현재 running 중인 thread를 ready queue에 넣어주고, ready queue에 있는 스레드 중 최우선순위를 실행시킨다.
 	intr_set_level (old_level); // 이전 interuppt로 복구
 }
 
 /* alarm-multiple 관련 변경 */
-/* block current thread, and insert it into sleep list */
-void
-thread_sleep (int64_t ticks) {
-	enum intr_level old_level;
-	old_level = intr_disable ();
-	struct thread *curr = thread_current();
-	// ASSERT (!intr_context ());
-	ASSERT(curr != idle_thread); // check that current thread is not IDLE thread
-	
-	curr->wakeup_tick = ticks; // set current thread's local tick = ticks
-	update_next_tick_to_awake(ticks); // update next thread to be awakened which has minimal ticks (update_next_tick_to_awake)
-	list_push_back (&sleep_list, &curr->elem); // insert into sleep list
-	
-	thread_block(); // change state to BLOCKED
-	intr_set_level (old_level);
-}
+/* timer event callback of thread_sleep(): wakes the sleeping thread T,
+   preempting the interrupted thread if T has a higher priority. */
+static void
+thread_wake (void *t_) {
+	struct thread *t = t_;
 
-/* alarm-multiple 관련 변경 */
-/* check every threads in the sleep list and wakeup if necessary */
-void 
-thread_awake(int64_t ticks){
-	struct list_elem *e = list_begin(&sleep_list);
-	next_tick_to_awake = INT64_MAX; // initialize next_tick_to_awake
-	while (e != list_end(&sleep_list)){
-		struct thread * t = list_entry(e, struct thread, elem);
-		if (t->wakeup_tick <= ticks){
-			e = list_remove(&t->elem);
-			thread_unblock(t); // wakeup (awake) !
-		}
-		else{
-			e = list_next(e);
-			update_next_tick_to_awake(t->wakeup_tick); // update next_tick_to_awake if needed
-		}
-	}
+	thread_unblock (t);
+	if (t->priority > thread_current ()->priority)
+		intr_yield_on_return ();
 }
 
-/* alarm-multiple 관련 변경 */
-/* update the next_tick_to_awake value if needed. 
-   parameter 'ticks' is the local tick(wakeup_tick field) of the new thread inserted into sleep list */
+/* Blocks the current thread until timer tick TICKS. The wakeup is a
+   timer event on the sleeper's stack, so no list of sleepers has to
+   be scanned on each tick. */
 void
-update_next_tick_to_awake(int64_t ticks){
-	next_tick_to_awake = (next_tick_to_awake > ticks) ? ticks : next_tick_to_awake;
-}
+thread_sleep (int64_t ticks) {
+	struct thread *curr = thread_current ();
+	struct timer_event ev;
+	enum intr_level old_level;
 
-/* alarm-multiple 관련 변경 */
-/* return the next_tick_to_awake value, in order to check which thread(in the sleep list) to awake next */
-int64_t 
-get_next_tick_to_awake(void){
-	return next_tick_to_awake;
+	ASSERT (!intr_context ());
+	ASSERT (curr != idle_thread);
+
+	timer_event_init (&ev, thread_wake, curr);
+	old_level = intr_disable ();
+	timer_event_add (&ev, ticks);
+	thread_block ();
+	intr_set_level (old_level);
 }
 
 /* alarm-priority, priority-fifo/preempt 관련 변경 */
@@ -451,7 +452,7 @@ thread_get_priority (void) {
 /* check if current thread is still the highest priority thread. if not, yield. */
 void 
 check_curr_max_priority(void){
-	if (!intr_context() && !list_empty (&ready_list) && thread_current ()->priority < list_entry (list_front (&ready_list), struct thread, elem)->priority)
+	if (!intr_context() && thread_current ()->priority < ready_max_priority ())
         thread_yield ();
 }
 
@@ -478,7 +479,7 @@ donate_priority(void){
 	for (depth = 0; depth < MAXDEPTH; depth++){
 		if (!target_lock) // if caller is not waiting for a lock, end of the loop
 			return;
-		target_lock->holder->priority = target_lock_caller->priority; /* donation */ 
+		change_priority (target_lock->holder, target_lock_caller->priority); /* donation. holder 가 ready 상태면 run queue 도 옮긴다 */
 		target_lock_caller = target_lock->holder; // update caller to check if further donation is needed
 		target_lock = target_lock_caller->wait_on_lock; // update target lock (the lock which new caller is waiting for)
 	}
@@ -576,7 +577,21 @@ thread_get_recent_cpu (void) {
 void mlfqs_priority (struct thread *t){
 	if (t == idle_thread)
 		return;
-	t->priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->nice * 2));
+	change_priority (t, mlfqs_calc_priority (t));
+}
+
+/* mlfqs 관련 변경 */
+/* Returns the mlfqs priority of T from its recent_cpu and nice. */
+static int
+mlfqs_calc_priority (struct thread *t) {
+	int priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->nice * 2));
+
+	/* run queue 의 index 이므로 범위를 벗어나면 안 된다. */
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	else if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	return priority;
 }
 
 // mlfqs 관련 변경
@@ -590,11 +605,11 @@ void mlfqs_recent_cpu (struct thread *t){
 // mlfqs 관련 변경
 /* caculate load_avg which is used system-wide (not thread specific) */
 void mlfqs_load_avg (void){
-	int ready_threads = list_size(&ready_list);
+	int ready_threads = ready_cnt;
 	struct thread *curr = thread_current();
 	if (curr != idle_thread)
 		ready_threads ++;
-	// ready_threads += list_size(&ready_list);
+	// ready_threads += ready_cnt;
 	/* if current thread is not idle thread, ready_threads should include the running thread. therefore, ready_threads ++ */
 	// if (curr != idle_thread)
 	// 	ready_threads ++;
@@ -613,14 +628,69 @@ void mlfqs_increment (void){
 }
 
 // mlfqs 관련 변경
-// recalculate every thread's recent_cpu & priority
+/* Once a second: records this second's recent_cpu decay and applies it
+   to the running and ready threads only. Blocked threads are caught up
+   by mlfqs_catch_up() when they are unblocked, so the pass does not
+   grow with the number of sleeping threads. */
 void mlfqs_recalc(void)
 {
-	struct list_elem *e;
-	for(e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)){
-		mlfqs_recent_cpu(list_entry(e, struct thread, all_elem));
-		mlfqs_priority(list_entry(e, struct thread, all_elem));
+	struct thread *curr = thread_current();
+	struct list runnable;
+	int pri;
+
+	decay_hist[mlfqs_seconds % DECAY_HIST] = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
+	mlfqs_seconds++;
+
+	mlfqs_recent_cpu(curr);
+	curr->mlfqs_epoch = mlfqs_seconds;
+	mlfqs_priority(curr);
+
+	/* priority 가 바뀌면 run queue 를 옮겨야 하니 전부 꺼냈다가 다시 넣는다. */
+	list_init(&runnable);
+	for (pri = PRI_MAX; pri >= PRI_MIN; pri--)
+		while (!list_empty(&ready_queues[pri]))
+			list_push_back(&runnable, list_pop_front(&ready_queues[pri]));
+	ready_bitmap = 0;
+	ready_cnt = 0;
+	while (!list_empty(&runnable)) {
+		struct thread *t = list_entry(list_pop_front(&runnable), struct thread, elem);
+
+		mlfqs_recent_cpu(t);
+		t->mlfqs_epoch = mlfqs_seconds;
+		t->priority = mlfqs_calc_priority(t);
+		ready_push(t);
+	}
+}
+
+// mlfqs 관련 변경
+/* Applies to T, which is blocked, the recent_cpu decay of every second
+   since it was last updated, using the coefficients recorded by
+   mlfqs_recalc(), and recomputes its priority. A thread that slept
+   longer than DECAY_HIST seconds gets the oldest recorded coefficient
+   for the seconds before that. */
+static void
+mlfqs_catch_up (struct thread *t) {
+	int64_t oldest = mlfqs_seconds - DECAY_HIST;
+	int64_t s = t->mlfqs_epoch;
+	int i;
+
+	if (t == idle_thread || s == mlfqs_seconds)
+		return;
+	/* 같은 계수를 반복 적용하므로 값이 더 변하지 않으면 멈춘다. */
+	for (i = 0; s < oldest && i < DECAY_HIST; s++, i++) {
+		int rc = add_mixed(mult_fp(decay_hist[oldest % DECAY_HIST], t->recent_cpu), t->nice);
+
+		if (rc == t->recent_cpu)
+			break;
+		t->recent_cpu = rc;
 	}
+	if (s < oldest)
+		s = oldest;
+	/* nice 가 0 이면 0 에 닿은 뒤로는 계속 0 이다. */
+	for (; s < mlfqs_seconds && (t->recent_cpu != 0 || t->nice != 0); s++)
+		t->recent_cpu = add_mixed(mult_fp(decay_hist[s % DECAY_HIST], t->recent_cpu), t->nice);
+	t->mlfqs_epoch = mlfqs_seconds;
+	mlfqs_priority(t);
 }
 
 
@@ -644,6 +714,7 @@ idle (void *idle_started_ UNUSED) {
 		/* Let someone else run. */
 		intr_disable ();
 		thread_block ();
+		timer_idle_enter ();
 
 		/* Re-enable interrupts and wait for the next one.
 
@@ -658,6 +729,7 @@ idle (void *idle_started_ UNUSED) {
 		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
 		   7.11.1 "HLT Instruction". */
 		asm volatile ("sti; hlt" : : : "memory");
+		timer_idle_exit ();
 	}
 }
 
@@ -695,15 +767,13 @@ init_thread (struct thread *t, const char *name, int priority) {
 	/* mlfqs 관련 변경 */
 	t->nice = NICE_DEFAULT;
 	t->recent_cpu = RECENT_CPU_DEFAULT;
+	t->mlfqs_epoch = mlfqs_seconds;
 
 	list_init(&t->child_list); //자식 프로세스 리스트 초기화
 	sema_init(&t->wait_sema,0);
 	sema_init(&t->fork_sema,0);
 	sema_init(&t->free_sema,0);
 
-	if(t!= idle_thread){
-		list_push_back (&all_list, &t->all_elem);
-	}
 	/* system call 관련 변경 */
 	// t->exit_status = 0;
 }
@@ -715,10 +785,60 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	struct thread *t;
+
+	if (ready_bitmap == 0)
 		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	t = list_entry (list_front (&ready_queues[ready_max_priority ()]), struct thread, elem);
+	ready_remove (t);
+	return t;
+}
+
+/* Puts T, which must be ready, at the back of the run queue of its
+   priority.  Interrupts must be off. */
+static void
+ready_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	list_push_back (&ready_queues[t->priority], &t->elem);
+	ready_bitmap |= 1ULL << t->priority;
+	ready_cnt++;
+}
+
+/* Takes T out of its run queue.  Interrupts must be off. */
+static void
+ready_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->priority]))
+		ready_bitmap &= ~(1ULL << t->priority);
+	ready_cnt--;
+}
+
+/* Returns the highest priority of the ready threads, or PRI_MIN - 1
+   if no thread is ready. */
+static int
+ready_max_priority (void) {
+	if (ready_bitmap == 0)
+		return PRI_MIN - 1;
+	return 63 - __builtin_clzll (ready_bitmap);
+}
+
+/* Sets T's priority to PRIORITY.  A ready T moves to the back of the
+   run queue of its new priority, so this is O(1) whatever T's state. */
+static void
+change_priority (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->status == THREAD_READY && t->priority != priority) {
+		ready_remove (t);
+		t->priority = priority;
+		ready_push (t);
+	} else
+		t->priority = priority;
+	intr_set_level (old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -869,7 +989,6 @@ schedule (void) {
 		   schedule(). */
 		if (curr && curr->status == THREAD_DYING && curr != initial_thread) {
 			ASSERT (curr != next);
-			list_remove(&curr->all_elem); //mlfqs 관련 변경 // 여기가 6 FAIL의 원인이었음 
 			list_push_back (&destruction_req, &curr->elem);
 		}
 
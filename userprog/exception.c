@@ -9,6 +9,23 @@
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* Page faults by cause: how many, TSC cycles spent in all, and a
+   log2 histogram of the cycles of each. */
+struct fault_stat
+  {
+    long long cnt;
+    uint64_t cycles;
+    long long hist[FAULT_HIST_BUCKETS];
+  };
+static struct fault_stat fault_stats[FAULT_CAUSE_CNT];
+
+static const char *fault_cause_names[FAULT_CAUSE_CNT] = {
+	"uninit", "zero", "swap", "file", "stack", "cow", "bad",
+};
+
+static void fault_stat_add(enum fault_cause cause, uint64_t cycles);
+static void inspect_fault_stat(struct intr_frame *f);
+
 static void kill(struct intr_frame *);
 static void page_fault(struct intr_frame *);
 
@@ -58,12 +75,76 @@ void exception_init(void)
 	   We need to disable interrupts for page faults because the
 	   fault address is stored in CR2 and needs to be preserved. */
 	intr_register_int(14, 0, INTR_OFF, page_fault, "#PF Page-Fault Exception");
+
+	/* Lets user programs read the fault statistics. */
+	intr_register_int(0x45, 3, INTR_OFF, inspect_fault_stat, "Inspect Page Fault Statistics");
 }
 
 /* Prints exception statistics. */
 void exception_print_stats(void)
 {
 	printf("Exception: %lld page faults\n", page_fault_cnt);
+	for (int i = 0; i < FAULT_CAUSE_CNT; i++)
+	{
+		struct fault_stat *s = &fault_stats[i];
+		int last = FAULT_HIST_BUCKETS - 1;
+
+		if (s->cnt == 0)
+			continue;
+		while (last > 0 && s->hist[last] == 0)
+			last--;
+		printf("Exception: %-6s %lld faults, %llu cycles avg, log2 histogram from 2^%d:",
+			   fault_cause_names[i], s->cnt, s->cycles / s->cnt, FAULT_HIST_SHIFT);
+		for (int b = 0; b <= last; b++)
+			printf(" %lld", s->hist[b]);
+		printf("\n");
+	}
+}
+
+/* Counts a page fault of CAUSE that took CYCLES to handle. The
+ * faulting thread runs with interrupts on and may be preempted, so the
+ * counters are updated with interrupts disabled, which keeps them in
+ * step with each other and with inspect_fault_stat() (an INTR_OFF
+ * handler). */
+static void
+fault_stat_add(enum fault_cause cause, uint64_t cycles)
+{
+	struct fault_stat *s = &fault_stats[cause];
+	enum intr_level old_level;
+	int b = 0;
+
+	while (b < FAULT_HIST_BUCKETS - 1 && cycles >= (1ULL << (FAULT_HIST_SHIFT + b)))
+		b++;
+	old_level = intr_disable();
+	s->cnt++;
+	s->cycles += cycles;
+	s->hist[b]++;
+	intr_set_level(old_level);
+}
+
+/* Tool for reading the page fault statistics. Calling this function
+ * via int 0x45.
+ * Input:
+ *   @RDX - Cause, one of enum fault_cause
+ *   @RCX - Histogram bucket, or FAULT_HIST_BUCKETS for the number of
+ *          faults, or FAULT_HIST_BUCKETS + 1 for the cycles in all
+ * Output:
+ *   @RAX - The counter, or 0 for an unknown cause or bucket. */
+static void
+inspect_fault_stat(struct intr_frame *f)
+{
+	uint64_t cause = f->R.rdx;
+	uint64_t bucket = f->R.rcx;
+
+	f->R.rax = 0;
+	if (cause >= FAULT_CAUSE_CNT)
+		return;
+	if (bucket < FAULT_HIST_BUCKETS)
+		f->R.rax = fault_stats[cause].hist[bucket];
+	else if (bucket == FAULT_HIST_BUCKETS)
+		f->R.rax = fault_stats[cause].cnt;
+	else if (bucket == FAULT_HIST_BUCKETS + 1)
+		f->R.rax = fault_stats[cause].cycles;
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -125,6 +206,7 @@ page_fault(struct intr_frame *f)
 	bool write;		  /* True: access was write, false: access was read. */
 	bool user;		  /* True: access by user, false: access by kernel. */
 	void *fault_addr; /* Fault address. */
+	uint64_t start = rdtsc();
 	
 	/* Obtain faulting address, the virtual address that was
 	   accessed to cause the fault.  It may point to code or to
@@ -144,12 +226,17 @@ page_fault(struct intr_frame *f)
 
 #ifdef VM
 	/* For project 3 and later. */
+	thread_current()->fault_cause = FAULT_BAD;
 	if (vm_try_handle_fault(f, fault_addr, user, write, not_present))
+	{
+		fault_stat_add(thread_current()->fault_cause, rdtsc() - start);
 		return;
+	}
 #endif
 
 	/* Count page faults. */
 	page_fault_cnt++;
+	fault_stat_add(FAULT_BAD, rdtsc() - start);
 
 	/* If the fault is true fault, show info and exit. */
 	// printf ("Page fault at %p: %s error %s page in %s context.\n",
@@ -22,6 +22,7 @@
 #include "userprog/process.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/vma.h"
 #endif
 
 static void process_cleanup(void);
@@ -385,6 +386,11 @@ void process_exit(void)
 
 	file_close(curr->running); // denying writes to executable
 
+#ifdef VM
+	if (curr->pml4 != NULL)
+		vm_print_proc_stats(curr);
+#endif
+
 	process_cleanup();
 
 	sema_up(&curr->wait_sema);
@@ -786,36 +792,6 @@ install_page(void *upage, void *kpage, bool writable)
  * If you want to implement the function for only project 2, implement it on the
  * upper block. */
 /*project 3️⃣*/
-struct lazy_load_arg
-{
-	struct file *file;
-	off_t ofs;
-	uint32_t read_bytes;
-	uint32_t zero_bytes;
-};
-// 첫번쨰 page fault 가 발생할때 호출됨. 실행파일의 내용을 페이지로 로딩하는 함수.
-static bool
-lazy_load_segment(struct page *page, void *aux)
-{
-	/* TODO: Load the segment from the file */
-	/* TODO: This called when the first page fault occurs on address VA. */
-	/* TODO: VA is available when calling this function. */
-	struct lazy_load_arg *lazy_load_arg = (struct lazy_load_arg *)aux;
-
-	// 1) 파일의 position을 ofs으로 지정한다.
-	file_seek(lazy_load_arg->file, lazy_load_arg->ofs);
-	// 2) 파일을 read_bytes만큼 물리 프레임에 읽어 들인다.
-	if (file_read(lazy_load_arg->file, page->frame->kva, lazy_load_arg->read_bytes) != (int)(lazy_load_arg->read_bytes))
-	{
-		palloc_free_page(page->frame->kva);
-		return false;
-	}
-	// 3) 다 읽은 지점부터 zero_bytes만큼 0으로 채운다.
-	memset(page->frame->kva + lazy_load_arg->read_bytes, 0, lazy_load_arg->zero_bytes);
-
-	return true;
-}
-
 /* Loads a segment starting at offset OFS in FILE at address
  * UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
  * memory are initialized, as follows:
@@ -839,35 +815,12 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT(pg_ofs(upage) == 0);						 // upage 페이지 정렬되어있는지 확인
 	ASSERT(ofs % PGSIZE == 0);						 // ofs가 페이지 정렬 되어있는지 확인
 
-	while (read_bytes > 0 || zero_bytes > 0) // read_byte, zero_bytes가 0보다 클때 동안 루프
-	{
-		/* Do calculate how to fill this page.
-		 * We will read PAGE_READ_BYTES bytes from FILE
-		 * and zero the final PAGE_ZERO_BYTES bytes. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE; // 최대로 읽을 수 있는 크기는 PGSIZE
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		// 페이지에 내용을 로드할때 사용할 함수와 필요한 인자 넣어주기.
-		//  vm_alloc_page_with initializer 의 4,5 번쨰 인자가 로드할때 사용할 함수, 필요한 인자.
-		struct lazy_load_arg *lazy_load_arg = (struct lazy_load_arg *)malloc(sizeof(struct lazy_load_arg));
-		lazy_load_arg->file = file;					 // 내용이 담긴 파일 객체
-		lazy_load_arg->ofs = ofs;					 // 이 페이지에서 읽기 시작할 위치
-		lazy_load_arg->read_bytes = page_read_bytes; // 이 페이지에서 읽어야 하는 바이트 수
-		lazy_load_arg->zero_bytes = page_zero_bytes; // 이 페이지에서 read_bytes만큼 읽고 공간이 남아 0으로 채워야 하는 바이트 수
-		// vm_alloc_page_with_initializer를 호출하여 대기 중인 객체를 생성합니다.
-		if (!vm_alloc_page_with_initializer(VM_ANON, upage,
-											writable, lazy_load_segment, lazy_load_arg))
-			return false;
-
-		/* Advance. */
-		// 다음 반복을 위하여 읽어들인 만큼 값을 갱신합니다.
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-		ofs += page_read_bytes;
-	}
-	return true;
+	// 페이지를 하나씩 만들지 않고 세그먼트 전체를 영역 하나로 등록한다.
+	// 각 페이지는 처음 fault 가 날 때 vma_get_page() 가 만들어서 읽어 들인다.
+	// 읽기 전용 세그먼트(코드, rodata)는 파일 페이지로 두어 evict 때 스왑에 쓰지 않고 버린다.
+	enum vm_type type = (writable ? VM_ANON : VM_FILE) | VM_SEGMENT;
+	return vma_add(&thread_current()->spt, upage, read_bytes + zero_bytes, file, ofs,
+				   read_bytes, writable, type) != NULL;
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
@@ -17,6 +17,7 @@
 #include "userprog/process.h"
 #include "threads/synch.h"
 #include "vm/vm.h"
+#include "vm/vma.h"
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
@@ -44,6 +45,8 @@ static struct file *process_get_file(int fd);
 int process_add_file(struct file *file);
 void process_close_file(int fd);
 void *call_mmap(void *, size_t, int, int, off_t);
+int msync(void *addr, size_t length);
+int madvise(void *addr, size_t length, int advice);
 /* Project2-extra */
 const int STDIN = 1;
 const int STDOUT = 2;
@@ -186,6 +189,12 @@ void syscall_handler(struct intr_frame *f UNUSED)
 	case SYS_MUNMAP:
 		munmap(f->R.rdi);
 		break;
+	case SYS_MSYNC:
+		f->R.rax = msync((void *)f->R.rdi, f->R.rsi);
+		break;
+	case SYS_MADVISE:
+		f->R.rax = madvise((void *)f->R.rdi, f->R.rsi, f->R.rdx);
+		break;
 	default: /* call thread_exit() ? */
 		exit(-1);
 		break;
@@ -454,8 +463,8 @@ void *call_mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	}
 
 	struct supplemental_page_table *spt = &thread_current()->spt;
-	// 다른 애가 이미 쓰고있으면 안되니까!!!
-	if (spt_find_page(spt, addr))
+	// 다른 애가 이미 쓰고있으면 안되니까!!! 영역 전체가 비어 있어야 한다.
+	if (!vma_range_free(spt, addr, length))
 	{
 		return NULL;
 	}
@@ -475,6 +484,19 @@ void *call_mmap(void *addr, size_t length, int writable, int fd, off_t offset)
 	return do_mmap(addr, length, writable, f, offset);
 }
 
+int msync(void *addr, size_t length)
+{
+	return do_msync(addr, length);
+}
+
+/* Gives advice on how the mmap regions and executable segments in
+ * the range will be used (vma_advise()). The stack is not a region,
+ * so advice on it fails with -1. */
+int madvise(void *addr, size_t length, int advice)
+{
+	return vma_advise(&thread_current()->spt, addr, length, advice);
+}
+
 void munmap(void *addr)
 {
 	do_munmap(addr);
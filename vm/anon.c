@@ -1,17 +1,30 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #include "devices/disk.h"
 #include "bitmap.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include <list.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 
 // 4096 / 512
 #define SECTORS_PER_PAGE 8
+// 스왑 슬롯을 이 개수씩 묶어서 하나의 cluster 로 관리한다 (16 * 4 KiB = 64 KiB).
+#define SWAP_CLUSTER_SLOTS 16
+// swap readahead 로 한 번에 읽는 최대 페이지 수 (fault 난 페이지 포함).
+#define SWAP_RA_MAX 16
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
 static struct bitmap *swap_table;
 static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
+static int anon_writeback(const void *kva);
+static void anon_slot_free(int slot);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -21,6 +34,195 @@ static const struct page_operations anon_ops = {
 	.type = VM_ANON,
 };
 
+/* 스왑 슬롯 allocator.
+ * 슬롯을 SWAP_CLUSTER_SLOTS 개씩 cluster 로 나누고, 지금 채우고 있는 cluster
+ * 하나(cur_cluster) 안에서 next-fit 커서로 슬롯을 나눠준다. 연달아 evict 되는
+ * 페이지들은 디스크에서도 붙어 있게 된다. cur_cluster 가 차면 완전히 빈
+ * cluster 를, 없으면 일부만 빈 cluster 를 리스트 맨 앞에서 꺼내 쓰므로
+ * 빈 슬롯 찾기는 cluster 크기에만 비례한다 (O(1)). */
+enum swap_cluster_state
+{
+	CLUSTER_FREE,	 /* 모든 슬롯이 비어 있음. free_clusters 에 있음 */
+	CLUSTER_PARTIAL, /* 일부 슬롯이 비어 있음. partial_clusters 에 있음 */
+	CLUSTER_FULL,	 /* 빈 슬롯 없음. 어떤 리스트에도 없음 */
+	CLUSTER_CURRENT, /* cur_cluster. 어떤 리스트에도 없음 */
+};
+
+struct swap_cluster
+{
+	size_t free_cnt; /* 이 cluster 의 빈 슬롯 수 */
+	enum swap_cluster_state state;
+	struct list_elem elem;
+};
+
+static struct lock swap_lock;
+static struct swap_cluster *clusters;
+static size_t cluster_cnt;
+static struct list free_clusters;
+static struct list partial_clusters;
+static struct swap_cluster *cur_cluster; /* 지금 슬롯을 나눠주는 cluster */
+static size_t cur_slot;					 /* cur_cluster 안의 next-fit 커서 */
+
+/* Returns the first slot of cluster CL. */
+static size_t
+cluster_start(const struct swap_cluster *cl)
+{
+	return (size_t)(cl - clusters) * SWAP_CLUSTER_SLOTS;
+}
+
+/* Returns the number of slots in cluster CL. Only the last one can be short. */
+static size_t
+cluster_size(const struct swap_cluster *cl)
+{
+	size_t start = cluster_start(cl);
+	size_t end = start + SWAP_CLUSTER_SLOTS;
+	size_t slot_cnt = bitmap_size(swap_table);
+
+	return (end < slot_cnt ? end : slot_cnt) - start;
+}
+
+/* Allocates one swap slot and returns its index,
+ * or BITMAP_ERROR if the swap disk is full. */
+static size_t
+swap_slot_alloc(void)
+{
+	size_t slot = BITMAP_ERROR;
+
+	lock_acquire(&swap_lock);
+	if (cur_cluster == NULL || cur_cluster->free_cnt == 0)
+	{
+		struct list *from = NULL;
+
+		if (cur_cluster != NULL)
+			cur_cluster->state = CLUSTER_FULL;
+		cur_cluster = NULL;
+
+		if (!list_empty(&free_clusters))
+			from = &free_clusters;
+		else if (!list_empty(&partial_clusters))
+			from = &partial_clusters;
+
+		if (from != NULL)
+		{
+			cur_cluster = list_entry(list_pop_front(from), struct swap_cluster, elem);
+			cur_cluster->state = CLUSTER_CURRENT;
+			cur_slot = cluster_start(cur_cluster);
+		}
+	}
+
+	if (cur_cluster != NULL)
+	{
+		size_t start = cluster_start(cur_cluster);
+		size_t end = start + cluster_size(cur_cluster);
+
+		// 커서부터 cluster 끝까지, 없으면 cluster 처음부터 다시 본다. free_cnt 가
+		// 0이 아니므로 cluster 안에서 반드시 찾고, 많아야 cluster 크기만큼 본다.
+		for (slot = cur_slot; slot < end && bitmap_test(swap_table, slot); slot++)
+			continue;
+		if (slot == end)
+			for (slot = start; slot < cur_slot && bitmap_test(swap_table, slot); slot++)
+				continue;
+		ASSERT(slot < end && !bitmap_test(swap_table, slot));
+
+		bitmap_mark(swap_table, slot);
+		cur_cluster->free_cnt--;
+		cur_slot = slot + 1 < end ? slot + 1 : start;
+	}
+	lock_release(&swap_lock);
+	return slot;
+}
+
+/* Gives SLOT back to the allocator. */
+static void
+swap_slot_free(size_t slot)
+{
+	struct swap_cluster *cl = &clusters[slot / SWAP_CLUSTER_SLOTS];
+
+	lock_acquire(&swap_lock);
+	ASSERT(bitmap_test(swap_table, slot));
+	bitmap_reset(swap_table, slot);
+	cl->free_cnt++;
+
+	if (cl->state != CLUSTER_CURRENT)
+	{
+		if (cl->free_cnt == cluster_size(cl))
+		{
+			// 다 비었으면 새 batch 를 통째로 받을 수 있도록 free 리스트로 옮긴다.
+			if (cl->state == CLUSTER_PARTIAL)
+				list_remove(&cl->elem);
+			cl->state = CLUSTER_FREE;
+			list_push_back(&free_clusters, &cl->elem);
+		}
+		else if (cl->state == CLUSTER_FULL)
+		{
+			cl->state = CLUSTER_PARTIAL;
+			list_push_back(&partial_clusters, &cl->elem);
+		}
+	}
+	lock_release(&swap_lock);
+}
+
+/* Swap readahead.
+ * swap-in fault 가 나면 같은 프로세스의 바로 다음 가상 페이지들 중 바로 다음
+ * 스왑 슬롯에 들어 있는 것들을 spt->ra_window 개까지 같이 읽는다. 같이 읽은
+ * 페이지는 프레임에 연결만 하고 매핑은 하지 않아서, 나중에 fault 가 나면 hit 로
+ * 센다. fault 가 순차적이거나 hit 가 나면 window 를 두 배로, 한 번도 안 쓰이고
+ * 쫓겨나면 (miss) 절반으로 줄인다. window 와 순차 접근 판단은 프로세스마다
+ * 따로 해서, 한 프로세스의 임의 접근이 다른 프로세스의 순차 읽기를 막지 않는다. */
+#define SWAP_RA_INIT 4
+
+static long long ra_cnt;  /* # of pages read ahead. */
+static long long ra_hit;  /* # of read-ahead pages that were used. */
+static long long ra_miss; /* # of read-ahead pages evicted unused. */
+
+static void
+ra_window_grow(struct supplemental_page_table *spt)
+{
+	spt->ra_window = spt->ra_window * 2 < SWAP_RA_MAX ? spt->ra_window * 2 : SWAP_RA_MAX;
+}
+
+static void
+ra_window_shrink(struct supplemental_page_table *spt)
+{
+	spt->ra_window = spt->ra_window / 2 > 1 ? spt->ra_window / 2 : 1;
+}
+
+/* Sets up the readahead state of a new process's SPT. */
+void anon_readahead_init(struct supplemental_page_table *spt)
+{
+	spt->ra_window = SWAP_RA_INIT;
+	spt->ra_next_va = NULL;
+}
+
+/* Called when a read-ahead PAGE is first mapped (HIT) or
+ * leaves memory without being used. */
+void anon_readahead_feedback(struct page *page, bool hit)
+{
+	struct anon_page *anon_page = &page->anon;
+
+	if (!anon_page->readahead)
+		return;
+	anon_page->readahead = false;
+	if (hit)
+	{
+		ra_hit++;
+		ra_window_grow(&page->owner->spt);
+	}
+	else
+	{
+		ra_miss++;
+		ra_window_shrink(&page->owner->spt);
+	}
+}
+
+/* Prints swap statistics. */
+void vm_anon_print_stats(void)
+{
+	printf("Swap: %lld pages read ahead, %lld hits, %lld misses\n",
+		   ra_cnt, ra_hit, ra_miss);
+	zswap_print_stats();
+}
+
 /* Initialize the data for anonymous pages */
 void vm_anon_init(void)
 {
@@ -31,6 +233,22 @@ void vm_anon_init(void)
 	size_t swap_size = disk_size(swap_disk) / SECTORS_PER_PAGE;
 
 	swap_table = bitmap_create(swap_size);
+
+	lock_init(&swap_lock);
+	list_init(&free_clusters);
+	list_init(&partial_clusters);
+	cur_cluster = NULL;
+	cluster_cnt = DIV_ROUND_UP(swap_size, SWAP_CLUSTER_SLOTS);
+	clusters = malloc(sizeof *clusters * cluster_cnt);
+	if (clusters == NULL && cluster_cnt > 0)
+		PANIC("vm: cannot allocate swap clusters");
+	for (size_t i = 0; i < cluster_cnt; i++)
+	{
+		clusters[i].state = CLUSTER_FREE;
+		clusters[i].free_cnt = cluster_size(&clusters[i]);
+		list_push_back(&free_clusters, &clusters[i].elem);
+	}
+	zswap_init(anon_writeback, anon_slot_free);
 }
 
 /* Initialize the file mapping */
@@ -43,6 +261,8 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 	page->operations = &anon_ops;
 	struct anon_page *anon_page = &page->anon;
 	anon_page->swap_sec = -1;
+	anon_page->readahead = false;
+	anon_page->zswap = NULL;
 	return true;
 }
 
@@ -51,20 +271,58 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 static bool anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
+	struct supplemental_page_table *spt = &page->owner->spt;
 
-	int page_no = anon_page->swap_sec;
+	int page_no;
+	struct page *ra_pages[SWAP_RA_MAX];
+	struct frame *ra_frames[SWAP_RA_MAX];
+	void *bufs[SWAP_RA_MAX];
+	size_t n;
 
-	if (bitmap_test(swap_table, page_no) == false)
-	{
+	// 압축되어 메모리에 남아 있으면 디스크까지 갈 필요가 없다.
+	if (zswap_load(page, kva))
+		return true;
+	// zswap_load 가 실패한 뒤에는 writeback 이 swap_sec 을 바꾸지 않는다.
+	page_no = anon_page->swap_sec;
+	if (page_no == -1)
 		return false;
-	}
 
-	for (int i = 0; i < SECTORS_PER_PAGE; ++i)
+	// 지난번 readahead 바로 뒤에서 fault 가 났다면 순차 접근이다.
+	if (page->va == spt->ra_next_va)
+		ra_window_grow(spt);
+
+	// 바로 다음 가상 페이지가 바로 다음 슬롯에 있는 동안 같이 읽을 페이지로 모은다.
+	// 빈 프레임이 없거나 상주 한도에 닿았으면 거기서 멈춘다. 미리 읽으려고
+	// 남의 페이지든 자기 페이지든 쫓아내지는 않는다.
+	bufs[0] = kva;
+	for (n = 1; n < (size_t)spt->ra_window; n++)
 	{
-		disk_read(swap_disk, page_no * SECTORS_PER_PAGE + i, kva + (DISK_SECTOR_SIZE * i));
+		struct page *next = spt_find_page(spt, page->va + n * PGSIZE);
+
+		if (next == NULL || next->operations != &anon_ops || next->frame != NULL ||
+			next->anon.swap_sec != page_no + (int)n)
+			break;
+		ra_frames[n] = vm_alloc_frame(spt);
+		if (ra_frames[n] == NULL)
+			break;
+		ra_pages[n] = next;
+		bufs[n] = ra_frames[n]->kva;
 	}
 
-	bitmap_set(swap_table, page_no, false);
+	// n 페이지를 명령 한 번으로 읽는다.
+	disk_read_pages(swap_disk, page_no * SECTORS_PER_PAGE, bufs, n);
+
+	swap_slot_free(page_no);
+	anon_page->swap_sec = -1;
+	for (size_t i = 1; i < n; i++)
+	{
+		swap_slot_free(page_no + i);
+		ra_pages[i]->anon.swap_sec = -1;
+		ra_pages[i]->anon.readahead = true;
+		vm_swap_cache_add(ra_pages[i], ra_frames[i]);
+	}
+	ra_cnt += n - 1;
+	spt->ra_next_va = page->va + n * PGSIZE;
 
 	return true;
 }
@@ -75,25 +333,22 @@ static bool anon_swap_out(struct page *page)
 
 	struct anon_page *anon_page = &page->anon;
 
-	int page_no = bitmap_scan(swap_table, 0, 1, false);
+	// 미리 읽어 왔는데 한 번도 안 쓰고 쫓겨나는 중
+	anon_readahead_feedback(page, false);
 
-	if (page_no == BITMAP_ERROR)
-	{
-		return false;
-	}
+	// 매핑은 쫓아내는 쪽이 frame_lock 을 잡고 먼저 지워 두었으므로 옮기는 동안
+	// 주인이 더 쓰지 못한다. 프레임에서 떼어내는 것도 그쪽에서 한다.
 
-	for (int i = 0; i < SECTORS_PER_PAGE; ++i)
+	// 먼저 압축해서 메모리에 두어 본다. 안 되면 디스크로.
+	if (!zswap_store(page, page->frame->kva))
 	{
-		disk_write(swap_disk, page_no * SECTORS_PER_PAGE + i, page->frame->kva + DISK_SECTOR_SIZE * i);
-	}
-
-	bitmap_set(swap_table, page_no, true);
-	pml4_clear_page(thread_current()->pml4, page->va);
-
-	anon_page->swap_sec = page_no;
-	page->frame->page = NULL;
-	page->frame = NULL;
+		size_t page_no = swap_slot_alloc();
 
+		if (page_no == BITMAP_ERROR)
+			return false;
+		disk_write_multi(swap_disk, page_no * SECTORS_PER_PAGE, SECTORS_PER_PAGE, page->frame->kva);
+		anon_page->swap_sec = page_no;
+	}
 	return true;
 }
 
@@ -102,4 +357,32 @@ static void
 anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
+
+	anon_readahead_feedback(page, false);
+	// 스왑 아웃된 채로 죽은 페이지라면 zswap 의 자리나 슬롯을 돌려준다.
+	if (page->frame == NULL && !zswap_invalidate(page) && anon_page->swap_sec != -1)
+		swap_slot_free(anon_page->swap_sec);
+}
+
+/* Writes a page that zswap is pushing out of its pool to a new swap
+ * slot and returns the slot, or -1 if the swap disk is full. Its
+ * contents were decompressed into KVA. zswap sets the page's swap_sec
+ * itself, under its lock. */
+static int
+anon_writeback(const void *kva)
+{
+	size_t page_no = swap_slot_alloc();
+
+	if (page_no == BITMAP_ERROR)
+		return -1;
+	disk_write_multi(swap_disk, page_no * SECTORS_PER_PAGE, SECTORS_PER_PAGE, kva);
+	return page_no;
+}
+
+/* Frees a slot anon_writeback() wrote for a page that no longer needs
+ * it. */
+static void
+anon_slot_free(int slot)
+{
+	swap_slot_free(slot);
 }
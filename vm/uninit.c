@@ -50,9 +50,9 @@ uninit_initialize(struct page *page, void *kva)
 	/* Fetch first, page_initialize may overwrite the values */
 	// page-initializer 함수가 값을 덮어쓸 수 있으므로, 이전에 가져온값 먼저 저장
 
-	// lazy_load_segment
+	// vma_load_page
 	vm_initializer *init = uninit->init;
-	// lazy_load_arg
+	// struct vma
 	void *aux = uninit->aux;
 
 	/* TODO: You may need to fix this function. */
@@ -3,221 +3,2070 @@
 #include "threads/malloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "userprog/exception.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "vm/vma.h"
 #include "hash.h"
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 
-struct lazy_load_arg
+/* 유저 풀의 페이지마다 하나씩 있는 프레임 테이블. palloc_user_index(kva) 번째
+ * 항목이 kva 의 프레임이다. 쓰이고 있는 항목은 FRAME_USED 가 켜져 있다. */
+static struct frame *frame_table;
+static size_t frame_table_cnt;
+static size_t frame_used_cnt; /* FRAME_USED 인 항목 수 */
+static uint64_t frame_stamp;  /* 마지막으로 준 frame->stamp */
+static struct lock frame_lock;
+/* 쫓아내기와 flushd, msync 는 내용을 쓰는 동안 frame_lock 을 놓는다. 그동안 그
+ * 프레임의 페이지를 건드리려는 스레드는 io_cond 에서 기다린다 (frame_wait_io). */
+static struct condition io_cond;
+static int evict_busy; /* frame_lock 을 놓고 쓰는 중인 쫓아내기 수 */
+/* clock 알고리즘의 시계 바늘. 다음에 검사할 frame_table 의 index. */
+static size_t clock_hand;
+
+enum vm_evict_policy vm_evict_policy = VM_EVICT_CLOCK;
+
+/* Free user frame watermarks for the reclaim thread, in pages.
+ * -1 means "pick from the size of the user pool" at vm_init(). */
+int vm_reclaim_low = -1;
+int vm_reclaim_high = -1;
+
+/* reclaimd 를 깨우는 세마포어. reclaim_pending 이면 이미 깨워둔 상태. */
+static struct semaphore reclaim_sema;
+static bool reclaim_pending;
+static bool reclaim_running;
+
+/* Statistics. */
+static long long fault_cnt;	  /* # of faults given to vm_try_handle_fault. */
+static long long evict_cnt;	  /* # of frames evicted by a faulting thread. */
+static long long reclaim_cnt; /* # of frames freed by reclaimd. */
+static long long cow_cnt;	  /* # of frames copied on a write to a shared page. */
+static long long around_cnt;  /* # of pages mapped ahead by fault-around. */
+static long long zero_map_cnt;	/* # of read faults served by zero_frame. */
+static long long zero_fill_cnt; /* # of zero_frame pages later written. */
+static long long huge_cnt;		/* # of 2 MiB anon regions mapped at once. */
+static long long local_evict_cnt; /* # of frames a process at its limit took from itself. */
+static long long text_share_cnt;  /* # of faults served by another process's text frame. */
+static long long text_drop_cnt;	  /* # of text frames evicted without a write. */
+static long long shared_evict_cnt; /* # of evicted frames that more than one page shared. */
+
+/* 읽기 전용 실행 파일 세그먼트의 페이지를 담은 프레임들. (inode, 파일 위치) 로
+ * 찾는다. 같은 실행 파일을 돌리는 프로세스들은 여기서 찾은 프레임을 같이
+ * 매핑한다. 프레임이 쓰이는 동안만 들어 있고 참조를 따로 잡지 않는다. */
+static struct hash text_frames;
+
+/* Per-process resident limit in pages; 0 means none. */
+int vm_rss_limit = 0;
+bool vm_rss_stats = false;
+
+/* Map fresh 2 MiB aligned anonymous regions with one large page. */
+bool vm_huge = false;
+
+/* 0으로 채워진 전역 프레임. 아직 아무도 쓰지 않은 anon 페이지를 읽기만 하면
+ * 이 프레임을 read-only 로 매핑해 준다. frame_table 에 없으므로 evict 되지 않고,
+ * 참조가 0이 되어도 해제하지 않는다. */
+static struct frame zero_frame;
+
+/* Pages fault-around maps per fault on a file-backed page, counting the
+ * faulting one. 1 turns fault-around off. */
+int vm_fault_around = 16;
+
+/* Same-page merging. ksmd 가 frame_table 을 조금씩 돌면서 내용이 같은 anon
+ * 프레임들을 하나의 read-only 프레임으로 합친다. 쓰기가 오면 vm_handle_wp 가
+ * COW 와 똑같이 떼어낸다. */
+bool vm_ksm = false;
+int vm_ksm_rate = 100;
+#define KSM_PASS_TICKS 10 /* ksmd 가 한 번 돌고 쉬는 시간 */
+
+/* frame->ksm 값. */
+enum
 {
-	struct file *file;
-	off_t ofs;
-	uint32_t read_bytes;
-	uint32_t zero_bytes;
+	KSM_NONE,	  /* 어느 테이블에도 없음 */
+	KSM_UNSTABLE, /* 이번 바퀴에 본 후보. 쓰기 가능하므로 내용이 바뀌었을 수 있다 */
+	KSM_STABLE,	  /* 합쳐진 프레임. 모든 매핑이 read-only */
+	KSM_PENDING,  /* ksmd 가 lock 을 놓고 비교하는 중. 쓰기가 오면 KSM_NONE 이 된다 */
+};
+
+/* checksum 으로 찾는 프레임 테이블들. */
+static struct hash ksm_stable;
+static struct hash ksm_unstable;
+/* ksmd 가 다음에 볼 frame_table 의 index. */
+static size_t ksm_cursor;
+static uint64_t zero_sum; /* zero_frame 내용의 checksum */
+
+static long long ksm_scan_cnt;	  /* # of frames ksmd checksummed. */
+static long long ksm_merge_cnt;	  /* # of frames freed by merging. */
+static long long ksm_unmerge_cnt; /* # of writes that copied a merged frame. */
+
+/* Dirty mmap writeback. flushd 가 FLUSH_PASS_TICKS 마다 frame_table 을 조금씩
+ * 돌면서 수정된 mmap 페이지를 파일 위치 순서로 되돌려 쓴다. 한 번에 최대
+ * vm_flush_rate 페이지만 써서 디스크를 독차지하지 않는다. */
+int vm_flush_rate = 32;
+#define FLUSH_PASS_TICKS 100 /* flushd 가 한 번 돌고 쉬는 시간 */
+#define FLUSH_BATCH_MAX 64	 /* 한 번에 모아 정렬하는 페이지 수의 상한 */
+/* flushd 가 다음에 볼 frame_table 의 index. */
+static size_t flush_cursor;
+
+static long long flush_cnt; /* # of pages written back by flushd. */
+static long long msync_cnt; /* # of pages written back by msync(). */
+
+/* madvise(WILLNEED) 요청들. prefetchd 가 앞에서부터 한 페이지씩 읽어서
+ * 프레임에 연결만 해 둔다 (swap readahead 와 같은 상태). 요청을 낸 프로세스는
+ * 그 페이지를 처음 건드릴 때 매핑만 하면 된다.
+ * prefetch_lock 은 prefetchd 가 페이지 하나를 다루는 동안 잡고 있다. 주인은
+ * 요청이 남아 있는 동안 page fault 를 이 lock 을 잡고 처리하고, 페이지를
+ * 지우기 전에는 vm_prefetch_cancel() 로 요청을 거둬들인다.
+ * Lock 순서: prefetch_lock -> frame_lock. */
+struct prefetch
+{
+	struct supplemental_page_table *spt;
+	uint8_t *next; /* 다음에 읽을 페이지 */
+	uint8_t *end;
+	struct list_elem elem;
 };
+static struct list prefetch_queue;
+static struct lock prefetch_lock;
+static struct semaphore prefetch_sema; /* 큐에 들어 있는 요청 수 */
+
+static long long prefetch_cnt; /* # of pages read in by prefetchd. */
+
+static void frame_table_init(void);
+static hash_hash_func text_hash;
+static hash_less_func text_less;
+static int spt_pff(const struct supplemental_page_table *spt);
+static void vm_reclaim_init(void);
+static void vm_reclaimd(void *aux);
+static void vm_ksm_init(void);
+static void vm_ksmd(void *aux);
+static void vm_flush_init(void);
+static void vm_flushd(void *aux);
+static void vm_prefetch_init(void);
+static void vm_prefetchd(void *aux);
 
-static struct list frame_list;
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void vm_init(void)
 {
-	list_init(&frame_list);
-	vm_anon_init();
-	vm_file_init();
-#ifdef EFILESYS /* For project 4 */
-	pagecache_init();
-#endif
-	register_inspect_intr();
-	/* DO NOT MODIFY UPPER LINES. */
+	frame_table_init();
+	lock_init(&frame_lock);
+	cond_init(&io_cond);
+	evict_busy = 0;
+	clock_hand = 0;
+	vm_anon_init();
+	vm_file_init();
+#ifdef EFILESYS /* For project 4 */
+	pagecache_init();
+#endif
+	register_inspect_intr();
+	/* DO NOT MODIFY UPPER LINES. */
+	zero_frame.kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	zero_frame.page = NULL;
+	zero_frame.state = FRAME_PINNED;
+	list_init(&zero_frame.pages);
+	zero_frame.ref_cnt = 0;
+	zero_frame.hold_cnt = 0;
+	hash_init(&text_frames, text_hash, text_less, NULL);
+	vm_reclaim_init();
+	vm_ksm_init();
+	vm_flush_init();
+	vm_prefetch_init();
+}
+
+/* Allocates frame_table from the kernel pool, one entry for every page
+ * the user pool spans. */
+static void
+frame_table_init(void)
+{
+	size_t pages;
+
+	frame_table_cnt = palloc_user_span();
+	pages = DIV_ROUND_UP(frame_table_cnt * sizeof *frame_table, PGSIZE);
+	frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO, pages > 0 ? pages : 1);
+	for (size_t i = 0; i < frame_table_cnt; i++)
+		frame_table[i].kva = palloc_user_page(i);
+}
+
+/* Fills in the default watermarks and starts reclaimd.
+ * A low watermark of 0 turns background reclaim off. */
+static void
+vm_reclaim_init(void)
+{
+	int user_pages = palloc_user_page_cnt();
+
+	if (vm_reclaim_low < 0)
+		vm_reclaim_low = user_pages / 32 > 2 ? user_pages / 32 : 2;
+	if (vm_reclaim_high < vm_reclaim_low)
+		vm_reclaim_high = vm_reclaim_low * 2;
+	if (vm_reclaim_high > user_pages)
+		vm_reclaim_high = user_pages;
+
+	sema_init(&reclaim_sema, 0);
+	reclaim_pending = false;
+	reclaim_running = vm_reclaim_low > 0
+		&& thread_create("reclaimd", PRI_DEFAULT, vm_reclaimd, NULL) != TID_ERROR;
+}
+
+/* Wakes reclaimd when the user pool is below the low watermark. */
+static void
+vm_reclaim_wakeup(void)
+{
+	if (reclaim_running && !reclaim_pending
+		&& palloc_user_free_cnt() < (size_t)vm_reclaim_low)
+	{
+		reclaim_pending = true;
+		sema_up(&reclaim_sema);
+	}
+}
+
+/* Selects the eviction policy by NAME ("fifo" or "clock").
+ * Returns false if NAME is not a known policy. */
+bool vm_set_evict_policy(const char *name)
+{
+	if (name == NULL)
+		return false;
+	if (!strcmp(name, "fifo"))
+		vm_evict_policy = VM_EVICT_FIFO;
+	else if (!strcmp(name, "clock"))
+		vm_evict_policy = VM_EVICT_CLOCK;
+	else
+		return false;
+	return true;
+}
+
+/* Prints VM statistics. */
+void vm_print_stats(void)
+{
+	printf("VM: %lld page faults, %lld evictions (%s), %lld COW copies\n",
+		   fault_cnt, evict_cnt, vm_evict_policy == VM_EVICT_CLOCK ? "clock" : "fifo",
+		   cow_cnt);
+	printf("VM: %lld shared frames evicted from every page sharing them\n",
+		   shared_evict_cnt);
+	printf("VM: frame table %zu entries, %zu in use\n", frame_table_cnt, frame_used_cnt);
+	printf("VM: reclaim watermarks %d/%d pages, %lld frames reclaimed in background\n",
+		   vm_reclaim_low, vm_reclaim_high, reclaim_cnt);
+	printf("VM: fault-around %d pages, %lld pages mapped without a fault\n",
+		   vm_fault_around, around_cnt);
+	printf("VM: %lld reads mapped the zero page, %lld of them later written\n",
+		   zero_map_cnt, zero_fill_cnt);
+	printf("VM: %lld huge pages mapped, %lld large mappings split\n",
+		   huge_cnt, pml4_split_cnt);
+	printf("VM: %lld text faults shared a frame, %zu text frames shared now, %lld dropped\n",
+		   text_share_cnt, hash_size(&text_frames), text_drop_cnt);
+	if (vm_rss_limit > 0)
+		printf("VM: resident limit %d pages, %lld frames reused within a process\n",
+			   vm_rss_limit, local_evict_cnt);
+	if (vm_ksm)
+		printf("VM: ksm %d frames/pass, %lld pages scanned, %lld merged, %lld unmerged\n",
+			   vm_ksm_rate, ksm_scan_cnt, ksm_merge_cnt, ksm_unmerge_cnt);
+	printf("VM: %lld mmap pages written back in background, %lld by msync\n",
+		   flush_cnt, msync_cnt);
+	printf("VM: %lld pages read ahead for madvise\n", prefetch_cnt);
+	vm_anon_print_stats();
+}
+
+/* Prints the paging counters of process T if "-rss-stats" was given:
+ * resident pages now and at most, faults in total and in the last PFF
+ * window, and pages taken away by eviction. A process that keeps
+ * faulting while losing pages is thrashing. */
+void vm_print_proc_stats(struct thread *t)
+{
+	struct supplemental_page_table *spt = &t->spt;
+
+	if (!vm_rss_stats)
+		return;
+	printf("%s: rss %zu pages (max %zu), %lld faults (%d in last %d ticks), %lld pages evicted\n",
+		   t->name, spt->rss, spt->rss_max, spt->fault_cnt, spt_pff(spt), VM_PFF_WINDOW,
+		   spt->evict_cnt);
+}
+
+/* Get the type of the page. This function is useful if you want to know the
+ * type of the page after it will be initialized.
+ * This function is fully implemented now. */
+enum vm_type
+page_get_type(struct page *page)
+{
+	int ty = VM_TYPE(page->operations->type);
+	switch (ty)
+	{
+	case VM_UNINIT:
+		return VM_TYPE(page->uninit.type);
+	default:
+		return ty;
+	}
+}
+
+/* Helpers */
+static struct frame *vm_get_victim(struct thread *owner);
+static bool vm_do_claim_page(struct page *page);
+static void *vm_evict_frame(struct thread *owner);
+static void frame_link(struct frame *frame, struct page *page);
+static int frame_unlink(struct page *page);
+static struct frame *frame_hold(struct page *page);
+static bool vm_fault_around_file(struct page *page, int window);
+static bool vm_map_zero_page(struct page *page);
+static bool vm_map_huge_anon(struct page *page);
+static bool spt_copy_page(struct page *src_page, void *dst_);
+static struct frame *frame_table_add(void *kva, bool pinned);
+static void frame_table_remove(struct frame *frame);
+static void frame_unpin(struct frame *frame);
+static void vm_free_frame(struct frame *frame);
+static void vm_unclaim_frame(struct page *page, struct frame *frame);
+static void ksm_forget(struct frame *frame);
+
+/* Create the pending page object with initializer. If you want to create a
+ * page, do not create it directly and make it through this function or
+ * `vm_alloc_page`. */
+// pending 중인 페이지 객체를 초기화하고 생성합니다.
+// 페이지를 생성하려면 직접 생성하지 말고 이 함수나 vm_alloc_page를 통해 만드세요.
+// init과 aux는 첫 page fault가 발생할 때 호출된다.
+bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writable,
+									vm_initializer *init, void *aux)
+{
+	ASSERT(VM_TYPE(type) != VM_UNINIT)
+
+	struct supplemental_page_table *spt = &thread_current()->spt;
+
+	/* Check wheter the upage is already occupied or not. */
+	// upage가 이미 사용 중인지 확인합니다.
+	if (spt_find_page(spt, upage) == NULL)
+	{
+		/* : Create the page, fetch the initialier according to the VM type,
+		 * : and then create "uninit" page struct by calling uninit_new. You
+		 * : should modify the field after calling the uninit_new. */
+		// 페이지를 생성하고,
+		struct page *p = (struct page *)malloc(sizeof(struct page));
+		// VM 유형에 따라 초기화 함수를 가져와서
+		//// 함수 포인터방식.. 함수 자체가 주소값을 가지고있기 때문에 이름만 넘기면 된다.
+		bool (*page_initializer)(struct page *, enum vm_type, void *);
+
+		switch (VM_TYPE(type))
+		{
+		case VM_ANON:
+			page_initializer = anon_initializer;
+			break;
+		case VM_FILE:
+			page_initializer = file_backed_initializer;
+			break;
+		}
+		// uninit_new를 호출해 "uninit" 페이지 구조체를 생성하세요.
+		uninit_new(p, upage, init, type, aux, page_initializer);
+		// uninit_new를 호출한 후에는 필드를 수정해야 합니다.
+		p->writable = writable;
+		p->owner = thread_current();
+
+		/* : Insert the page into the spt. */
+		// printf("여기까지 와?\n");
+		return spt_insert_page(spt, p);
+	}
+err:
+	return false;
+}
+
+/* Destroys PAGE, writing it back first if it is a dirty file page,
+ * and drops its frame. PAGE may be in the middle of being evicted; this
+ * waits for that, and keeps the frame from being evicted while
+ * destroy() writes it back. */
+static void
+vm_destroy_page(struct page *page)
+{
+	lock_acquire(&frame_lock);
+	frame_hold(page);
+	lock_release(&frame_lock);
+	// 프레임을 내려놓기 전에 destroy 해야 mmap 페이지를 되돌려 쓸 수 있다.
+	destroy(page);
+	vm_put_frame(page);
+}
+
+/* SPT radix tree. 가상 페이지 번호를 위에서부터 SPT_BITS 씩 잘라서
+ * 각 단계의 slot 번호로 쓴다 (pml4, pdpt, pd, pt 의 index 와 같다). */
+#define SPT_FANOUT (1 << SPT_BITS)
+
+struct spt_node
+{
+	void *slot[SPT_FANOUT]; /* 아래 단계 노드, 맨 아래에서는 struct page */
+};
+
+/* Returns the slot of virtual page number VPN in the bottom level
+ * node. Missing nodes are allocated if CREATE is true; otherwise, and
+ * if allocation fails, returns NULL. */
+static void **
+spt_slot(struct supplemental_page_table *spt, uint64_t vpn, bool create)
+{
+	struct spt_node **node = &spt->root;
+
+	for (int level = SPT_LEVELS - 1;; level--)
+	{
+		if (*node == NULL &&
+			(!create || (*node = palloc_get_page(PAL_ZERO)) == NULL))
+			return NULL;
+		if (level == 0)
+			return &(*node)->slot[vpn & (SPT_FANOUT - 1)];
+		node = (struct spt_node **)&(*node)->slot[(vpn >> (level * SPT_BITS)) & (SPT_FANOUT - 1)];
+	}
+}
+
+/* Find VA from spt and return page. On error, return NULL. */
+// spt에서 va에 해당하는 page를 찾아서 반환. malloc 없이 노드 SPT_LEVELS 개만 따라간다.
+struct page *
+spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
+{
+	void **slot;
+
+	if (!is_user_vaddr(va))
+		return NULL;
+	slot = spt_slot(spt, pg_no(va), false);
+	return slot != NULL ? *slot : NULL;
+}
+
+/* Insert PAGE into spt with validation. */
+bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
+					 struct page *page UNUSED)
+{
+	void **slot = spt_slot(spt, pg_no(page->va), true);
+
+	// 존재하지 않을 경우에만 삽입
+	if (slot == NULL || *slot != NULL)
+		return false;
+	*slot = page;
+	spt->page_cnt++;
+	return true;
+}
+
+/* Removes PAGE from SPT and frees it, writing it back first if it is
+ * a dirty file page. Empty nodes are kept until
+ * supplemental_page_table_kill(). */
+void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
+{
+	void **slot = spt_slot(spt, pg_no(page->va), false);
+
+	if (slot != NULL && *slot == page)
+	{
+		*slot = NULL;
+		spt->page_cnt--;
+	}
+	vm_destroy_page(page);
+	free(page);
+}
+
+/* Calls ACTION on the pages of NODE, a node at LEVEL whose first slot
+ * is page number BASE, that lie in pages FIRST...LAST. */
+static bool
+spt_node_for_each(struct spt_node *node, int level, uint64_t base,
+				  uint64_t first, uint64_t last, spt_action_func *action, void *aux)
+{
+	uint64_t span = (uint64_t)1 << (level * SPT_BITS);
+	size_t i = first > base ? (first - base) / span : 0;
+
+	for (; i < SPT_FANOUT && base + i * span <= last; i++)
+	{
+		void *child = node->slot[i];
+
+		if (child == NULL)
+			continue;
+		if (level == 0 ? !action(child, aux)
+					   : !spt_node_for_each(child, level - 1, base + i * span, first, last,
+											action, aux))
+			return false;
+	}
+	return true;
+}
+
+/* Calls ACTION on every page of SPT in START...END (END excluded), in
+ * address order. Subtrees with no pages are skipped as a whole.
+ * Returns false if ACTION stopped the walk. */
+bool spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux)
+{
+	if (spt->root == NULL || end <= start)
+		return true;
+	return spt_node_for_each(spt->root, SPT_LEVELS - 1, 0, pg_no(start),
+							 pg_no((uint8_t *)end - 1), action, aux);
+}
+
+/* Frees NODE at LEVEL and every node under it. */
+static void
+spt_node_free(struct spt_node *node, int level)
+{
+	if (level > 0)
+		for (size_t i = 0; i < SPT_FANOUT; i++)
+			if (node->slot[i] != NULL)
+				spt_node_free(node->slot[i], level - 1);
+	palloc_free_page(node);
+}
+
+/* Returns true if FRAME is in use by at least one page, not pinned and
+ * not held. 여러 페이지가 공유 중인 프레임은 vm_evict_victim() 이 모든
+ * 페이지의 매핑을 지우고 페이지마다 따로 내보낸다. */
+static bool
+frame_evictable(const struct frame *frame)
+{
+	return (frame->state & (FRAME_USED | FRAME_PINNED)) == FRAME_USED &&
+		   frame->page != NULL && frame->hold_cnt == 0;
+}
+
+/* Returns true if eviction looking for a frame of OWNER, or of anyone
+ * if OWNER is NULL, may take FRAME. A process at its resident limit
+ * only replaces frames no other process shares. */
+static bool
+frame_evictable_for(const struct frame *frame, const struct thread *owner)
+{
+	if (!frame_evictable(frame))
+		return false;
+	return owner == NULL || (frame->page->owner == owner && frame->ref_cnt == 1);
+}
+
+/* Returns true if the process owning SPT is at its resident limit. */
+static bool
+rss_at_limit(const struct supplemental_page_table *spt)
+{
+	return vm_rss_limit > 0 && spt->rss >= (size_t)vm_rss_limit;
+}
+
+/* Faults of the process owning SPT in its last full PFF window. A
+ * process that has not faulted for a whole window counts as 0. */
+static int
+spt_pff(const struct supplemental_page_table *spt)
+{
+	int64_t age = timer_ticks() - spt->pff_start;
+
+	if (age >= 2 * VM_PFF_WINDOW)
+		return 0;
+	if (age >= VM_PFF_WINDOW)
+		return spt->pff_cur;
+	return spt->pff_last;
+}
+
+/* Counts a fault of the process owning SPT. */
+static void
+spt_count_fault(struct supplemental_page_table *spt)
+{
+	int64_t now = timer_ticks();
+
+	spt->fault_cnt++;
+	if (now - spt->pff_start >= VM_PFF_WINDOW)
+	{
+		spt->pff_last = now - spt->pff_start < 2 * VM_PFF_WINDOW ? spt->pff_cur : 0;
+		spt->pff_start = now;
+		spt->pff_cur = 0;
+	}
+	spt->pff_cur++;
+}
+
+/* How much eviction would rather take FRAME than others: 3 if a
+ * sequential reader has gone past it (FRAME_COLD), 2 if eviction is
+ * looking at OWNER's frames only or FRAME's process is over its
+ * resident limit, 1 if the process rarely faults (it holds more frames
+ * than it is using), 0 otherwise. */
+#define VICTIM_RANK_MAX 3
+static int
+frame_victim_rank(const struct frame *frame, const struct thread *owner)
+{
+	const struct supplemental_page_table *spt = &frame->page->owner->spt;
+
+	if (frame->state & FRAME_COLD)
+		return VICTIM_RANK_MAX;
+	if (owner != NULL)
+		return 2;
+	if (vm_rss_limit > 0 && spt->rss > (size_t)vm_rss_limit)
+		return 2;
+	return spt_pff(spt) < VM_PFF_LOW ? 1 : 0;
+}
+
+/* Returns true if any page linked to FRAME was accessed since the last
+ * call, and clears the accessed bit of every one of them. */
+static bool
+frame_test_and_clear_accessed(struct frame *frame)
+{
+	bool accessed = false;
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *p = list_entry(e, struct page, share_elem);
+
+		if (pml4_is_accessed(p->owner->pml4, p->va))
+		{
+			pml4_set_accessed(p->owner->pml4, p->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Second chance: sweep the clock hand over frame_table. A frame whose
+ * page was accessed since the last sweep gets its accessed bit cleared
+ * and is skipped. Among the first VM_VICTIM_SCAN frames found with the
+ * bit clear, the one with the highest frame_victim_rank() is the
+ * victim; the others keep their clear bit for the next sweep. Two full
+ * sweeps always find one unless every frame is pinned.
+ * With OWNER, only OWNER's frames are looked at. */
+#define VM_VICTIM_SCAN 16
+static struct frame *
+vm_get_victim_clock(struct thread *owner)
+{
+	struct frame *victim = NULL;
+	int victim_rank = -1;
+	int found = 0;
+
+	for (size_t i = 0; i < 2 * frame_table_cnt && found < VM_VICTIM_SCAN; i++)
+	{
+		struct frame *frame = &frame_table[clock_hand];
+		clock_hand = clock_hand + 1 < frame_table_cnt ? clock_hand + 1 : 0;
+
+		if (!frame_evictable_for(frame, owner))
+			continue;
+
+		if (frame_test_and_clear_accessed(frame))
+		{
+			// 지나간 줄 알았던 페이지를 다시 쓰고 있다.
+			frame->state &= ~FRAME_COLD;
+			continue;
+		}
+		found++;
+		int rank = frame_victim_rank(frame, owner);
+		if (rank > victim_rank)
+		{
+			victim = frame;
+			victim_rank = rank;
+		}
+		// 꼭 내보내야 할 프레임이면 더 찾지 않는다.
+		if (rank >= 2)
+			break;
+	}
+	return victim;
+}
+
+/* FIFO: the frame taken into use first that is not pinned, among the
+ * frames of the highest frame_victim_rank(). With OWNER, only OWNER's
+ * frames are looked at. */
+static struct frame *
+vm_get_victim_fifo(struct thread *owner)
+{
+	struct frame *victim = NULL;
+	int victim_rank = -1;
+
+	for (size_t i = 0; i < frame_table_cnt; i++)
+	{
+		struct frame *frame = &frame_table[i];
+		int rank;
+
+		if (!frame_evictable_for(frame, owner))
+			continue;
+		rank = frame_victim_rank(frame, owner);
+		if (rank > victim_rank || (rank == victim_rank && frame->stamp < victim->stamp))
+		{
+			victim = frame;
+			victim_rank = rank;
+		}
+	}
+	return victim;
+}
+
+/* Get the struct frame, that will be evicted, from OWNER's frames or,
+ * if OWNER is NULL, from all frames. It stays in use until the caller
+ * has swapped its page out and calls frame_table_remove().
+ * Must hold frame_lock. Returns NULL if every frame is pinned or
+ * held. */
+static struct frame *
+vm_get_victim(struct thread *owner)
+{
+	ASSERT(lock_held_by_current_thread(&frame_lock));
+
+	if (vm_evict_policy == VM_EVICT_CLOCK)
+		return vm_get_victim_clock(owner);
+	return vm_get_victim_fifo(owner);
+}
+
+/* Waits until the frame of PAGE, if it has one, is not being evicted
+ * or written back and returns it, or NULL if PAGE is not in memory (any more). Must
+ * hold frame_lock; it is released while waiting. */
+static struct frame *
+frame_wait_io(struct page *page)
+{
+	struct frame *frame;
+
+	while ((frame = page->frame) != NULL
+		   && (frame->state & (FRAME_EVICTING | FRAME_WRITEBACK)))
+		cond_wait(&io_cond, &frame_lock);
+	return frame;
+}
+
+/* Like frame_wait_io(), but also keeps the frame from being evicted
+ * until vm_put_frame() lets it go, for a thread that is going to use
+ * it without frame_lock. Must hold frame_lock. */
+static struct frame *
+frame_hold(struct page *page)
+{
+	struct frame *frame = frame_wait_io(page);
+
+	if (frame != NULL)
+		frame->hold_cnt++;
+	return frame;
+}
+
+/* Writes every page linked to VICTIM, which vm_get_victim() just
+ * chose, out to its backing store and takes VICTIM out of use. A frame
+ * shared after fork or by ksmd is written once for each page, so every
+ * sharer gets a swap slot of its own. A text frame (FRAME_TEXT) is
+ * clean and read back from the executable, so it is only unmapped from
+ * every process and dropped. Otherwise frame_lock is released during
+ * the writes. Until they are done VICTIM stays pinned and
+ * FRAME_EVICTING, with all its mappings cleared, so that a fault on
+ * one of its pages and everyone else who looks at them waits in
+ * frame_wait_io(); nothing links to or unlinks from VICTIM
+ * meanwhile. Must hold frame_lock. */
+static void
+vm_evict_victim(struct frame *victim)
+{
+	struct list_elem *e;
+
+	victim->state |= FRAME_PINNED | FRAME_EVICTING;
+	// 쓰는 동안 주인들이 내용을 바꾸지 못하도록 매핑부터 지운다. dirty 비트는 남는다.
+	for (e = list_begin(&victim->pages); e != list_end(&victim->pages); e = list_next(e))
+	{
+		struct page *p = list_entry(e, struct page, share_elem);
+
+		p->owner->spt.evict_cnt++;
+		pml4_clear_page(p->owner->pml4, p->va);
+	}
+	if (victim->ref_cnt > 1)
+		shared_evict_cnt++;
+
+	if (victim->state & FRAME_TEXT)
+		// 읽기 전용 코드 페이지는 dirty 일 수 없으므로 쓸 것이 없다.
+		text_drop_cnt++;
+	else
+	{
+		evict_busy++;
+		lock_release(&frame_lock);
+
+		// NOTE - 페이지가, file-backed냐, anon이냐에 따라서 호출되는 하ㅏㅁ수가 달라짐.
+		// anonymous 인 경우, 디스크에[ backing store가 따로 없기 때문에 만들어 줘야 함.
+		for (e = list_begin(&victim->pages); e != list_end(&victim->pages); e = list_next(e))
+			if (!swap_out(list_entry(e, struct page, share_elem)))
+				PANIC("vm: swap out failed");
+
+		lock_acquire(&frame_lock);
+		evict_busy--;
+	}
+	while (!list_empty(&victim->pages))
+		frame_unlink(list_entry(list_front(&victim->pages), struct page, share_elem));
+	frame_table_remove(victim);
+	cond_broadcast(&io_cond, &frame_lock);
+}
+
+/* Evict one page of OWNER, or of any process if OWNER is NULL, and
+ * return the kva of its frame, zeroed and out of use. Returns NULL if
+ * OWNER has nothing to evict. Must hold frame_lock; it is released
+ * while the page is written out. */
+// 페이지를 배신..하고 다른데 가서 달라붙음.
+//  palloc 해서 NULL 이 나오는 경우, 다른 프레임 떼와서 붙여주기.
+//  전\체프레임 frame list, elem 으로 연결관리
+//  swap table 은 anony에만 필요.
+//  file은
+static void *
+vm_evict_frame(struct thread *owner)
+{
+	struct frame *victim = vm_get_victim(owner);
+	if (victim == NULL && owner != NULL)
+		return NULL;
+	// 다른 스레드가 쫓아내는 중이라 전부 고정되어 있을 수 있다. 끝나면 다시 찾는다.
+	while (victim == NULL && evict_busy > 0)
+	{
+		cond_wait(&io_cond, &frame_lock);
+		victim = vm_get_victim(NULL);
+	}
+	if (victim == NULL)
+		PANIC("vm: no frame to evict");
+	vm_evict_victim(victim);
+	evict_cnt++;
+	// 새 주인에게는 0으로 채워진 프레임을 준다 (PAL_ZERO 와 같은 약속).
+	memset(victim->kva, 0, PGSIZE);
+	return victim->kva;
+}
+
+/* palloc() and get frame. If there is no available page, evict the page
+ * and return it. This always return valid address. That is, if the user pool
+ * memory is full, this function evicts the frame to get the available memory
+ * space.*/
+// vm_try_handle_fault 에서, vm_clain_page가 불리는 경우는 스택을 늘려줘서 해결되는 것이 아닌 다른 경우
+// 의 fault 가 난 주소에 대해서, 페이지와 물리 프레임을 연결시켜주기 위해서
+// 이떄 물리 프레임을 연결시켜주려면, 빈 프레임을 찾아야 하는데, 이를 담당하는 함수 = vm_get_frame()
+static struct frame *
+vm_get_frame(void)
+{
+	struct frame *frame = NULL;
+	struct thread *t = thread_current();
+	void *kva = NULL;
+
+	// 상주 한도에 닿은 프로세스는 자기 페이지 하나를 내보내고 그 프레임을 다시 쓴다.
+	// 내보낼 게 없으면 (전부 공유 중이거나 고정) 한도를 넘겨서라도 새로 받는다.
+	if (rss_at_limit(&t->spt))
+	{
+		lock_acquire(&frame_lock);
+		kva = vm_evict_frame(t);
+		lock_release(&frame_lock);
+		if (kva != NULL)
+			local_evict_cnt++;
+	}
+	if (kva == NULL)
+	{
+		kva = palloc_get_page(PAL_USER | PAL_ZERO); // user pool에서 새로운 physical page를 가져온다.
+		// 빈 프레임이 low watermark 아래로 내려가면 reclaimd 가 미리 비워두게 한다.
+		vm_reclaim_wakeup();
+	}
+
+	lock_acquire(&frame_lock);
+	// palloc 으로 공간을 받오울 수가 없다면, evict를 통해 프레임을 차지하고있는 페이지를 쫓아내야 한다.
+	if (!kva)
+		kva = vm_evict_frame(NULL);
+	// 페이지 내용이 다 채워질 때까지 다른 스레드가 evict 하지 못하게 고정
+	frame = frame_table_add(kva, true);
+	lock_release(&frame_lock);
+
+	ASSERT(frame != NULL);
+	ASSERT(frame->page == NULL);
+
+	return frame;
+}
+
+/* Kernel thread that keeps free user frames between the watermarks.
+ * Woken through reclaim_sema when a frame allocation leaves fewer than
+ * vm_reclaim_low free frames; evicts pages until vm_reclaim_high frames
+ * are free, so that faults normally find a free frame in palloc and do
+ * not wait for a swap-out write themselves. */
+static void
+vm_reclaimd(void *aux UNUSED)
+{
+	for (;;)
+	{
+		sema_down(&reclaim_sema);
+		while (palloc_user_free_cnt() < (size_t)vm_reclaim_high)
+		{
+			struct frame *victim;
+
+			lock_acquire(&frame_lock);
+			victim = vm_get_victim(NULL);
+			if (victim == NULL)
+			{
+				lock_release(&frame_lock);
+				break;
+			}
+			// 내보내는 동안은 frame_lock 을 놓으므로 fault 들이 기다리지 않는다.
+			// palloc 에 돌려주기 전에 빼야 다른 스레드가 곧바로 다시 받아도 된다.
+			vm_evict_victim(victim);
+			lock_release(&frame_lock);
+
+			palloc_free_page(victim->kva);
+			reclaim_cnt++;
+		}
+		reclaim_pending = false;
+	}
+}
+
+/* Returns a pinned frame that is not linked to any page yet for swap
+ * readahead in anon.c, or NULL if the user pool is empty or the
+ * process owning SPT is at its resident limit. Unlike vm_get_frame()
+ * it never evicts: a page that may never be used is not worth anyone's
+ * resident page. */
+struct frame *
+vm_alloc_frame(const struct supplemental_page_table *spt)
+{
+	struct frame *frame;
+	void *kva;
+
+	if (rss_at_limit(spt))
+		return NULL;
+	kva = palloc_get_page(PAL_USER);
+	if (kva == NULL)
+		return NULL;
+	vm_reclaim_wakeup();
+
+	lock_acquire(&frame_lock);
+	frame = frame_table_add(kva, true);
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* Links PAGE to FRAME, which already holds PAGE's contents, without
+ * mapping it. The first fault on PAGE then only has to map the frame
+ * (vm_map_cached_page). FRAME must come from vm_alloc_frame(). */
+void vm_swap_cache_add(struct page *page, struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	frame_link(frame, page);
+	frame->state &= ~FRAME_PINNED;
+	lock_release(&frame_lock);
+}
+
+/* If PAGE already has a frame that is just not mapped (it was read in
+ * ahead of time), maps it and returns true. */
+static bool
+vm_map_cached_page(struct page *page)
+{
+	bool mapped = false;
+
+	lock_acquire(&frame_lock);
+	// 쫓겨나는 중이면 다 나간 뒤에 처음부터 읽어 온다.
+	if (frame_wait_io(page) != NULL)
+		mapped = pml4_set_page(page->owner->pml4, page->va, page->frame->kva,
+							   page->writable && page->frame->ref_cnt == 1);
+	lock_release(&frame_lock);
+
+	if (mapped && VM_TYPE(page->operations->type) == VM_ANON)
+		anon_readahead_feedback(page, true);
+	return mapped;
+}
+
+/* Returns true if PAGE is an anonymous page that has never been
+ * touched: no initializer, or an executable's BSS page with nothing
+ * to read. Its first contents are all zeros. */
+static bool
+is_fresh_anon(struct page *page)
+{
+	struct vma *vma = page->uninit.aux;
+
+	if (VM_TYPE(page->operations->type) != VM_UNINIT ||
+		VM_TYPE(page->uninit.type) != VM_ANON)
+		return false;
+	return page->uninit.init == NULL ||
+		   (vma != NULL && vma_page_read_bytes(vma, page->va) == 0);
+}
+
+/* Like is_fresh_anon() for the page at VA of SPT, which may not have
+ * been made from its region yet. */
+static bool
+is_fresh_anon_at(struct supplemental_page_table *spt, void *va, bool writable)
+{
+	struct page *page = spt_find_page(spt, va);
+	struct vma *vma;
+
+	if (page != NULL)
+		return is_fresh_anon(page) && page->writable == writable;
+	vma = vma_find(spt, va);
+	return vma != NULL && VM_TYPE(vma->type) == VM_ANON && vma->writable == writable &&
+		   vma_page_read_bytes(vma, va) == 0;
+}
+
+/* If PAGE is a fresh anonymous page, turns it into an anon page
+ * backed by zero_frame and maps it read-only. The first write then
+ * gets a private frame in vm_handle_wp(). */
+static bool
+vm_map_zero_page(struct page *page)
+{
+	if (!is_fresh_anon(page))
+		return false;
+
+	if (!page->uninit.page_initializer(page, page->uninit.type, zero_frame.kva))
+		return false;
+
+	lock_acquire(&frame_lock);
+	frame_link(&zero_frame, page);
+	lock_release(&frame_lock);
+
+	zero_map_cnt++;
+	return pml4_set_page(page->owner->pml4, page->va, zero_frame.kva, false);
+}
+
+/* Huge anonymous pages: if the whole 2 MiB aligned region around PAGE
+ * is fresh anonymous pages with the same permission, gives it 512
+ * physically contiguous frames and maps them with one large page.
+ * Each frame is still an ordinary 4 KiB frame in frame_table, so
+ * eviction, COW and ksmd work on them as usual; the first one to
+ * change a single mapping makes mmu.c split the large page.
+ * In practice this is the BSS of an executable (and any anon region
+ * made as a whole). The stack is not covered: vm_stack_growth() adds
+ * its pages one at a time, so the rest of its 2 MiB region is never
+ * there as fresh pages when the first one faults. */
+static bool
+vm_map_huge_anon(struct page *page)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	uint8_t *base = large_pg_round_down(page->va);
+	uint8_t *kva;
+	size_t i;
+
+	if (!vm_huge || !is_fresh_anon(page) || !is_user_vaddr(base + LARGE_PGSIZE - 1))
+		return false;
+	for (i = 0; i < LARGE_PGCNT; i++)
+		if (!is_fresh_anon_at(spt, base + i * PGSIZE, page->writable))
+			return false;
+	// 아직 만들어지지 않은 BSS 페이지들은 frame_lock 을 잡기 전에 만들어 둔다.
+	for (i = 0; i < LARGE_PGCNT; i++)
+		if (vma_get_page(spt, base + i * PGSIZE) == NULL)
+			return false;
+
+	kva = palloc_get_aligned(PAL_USER | PAL_ZERO, LARGE_PGCNT, LARGE_PGCNT);
+	if (kva == NULL)
+		return false;
+	vm_reclaim_wakeup();
+
+	// 전부 연결하고 매핑할 때까지 frame_lock 을 잡고 있으므로 고정할 필요가 없다.
+	lock_acquire(&frame_lock);
+	for (i = 0; i < LARGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		struct frame *frame = frame_table_add(kva + i * PGSIZE, false);
+
+		frame_link(frame, p);
+		p->uninit.page_initializer(p, p->uninit.type, frame->kva);
+	}
+
+	if (!pml4_set_large_page(page->owner->pml4, base, kva, page->writable))
+	{
+		// 큰 페이지를 못 쓰면 4 KiB 로 하나씩 매핑한다.
+		for (i = 0; i < LARGE_PGCNT; i++)
+			pml4_set_page(page->owner->pml4, base + i * PGSIZE, kva + i * PGSIZE,
+						  page->writable);
+		lock_release(&frame_lock);
+		return true;
+	}
+	huge_cnt++;
+	lock_release(&frame_lock);
+	return true;
+}
+
+/* Returns the key a text frame is filed under in text_frames. */
+static uint64_t
+text_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry(e, struct frame, text_elem);
+	return hash_bytes(&f->text_inode, sizeof f->text_inode) ^ hash_int(f->text_ofs);
+}
+
+static bool
+text_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED)
+{
+	const struct frame *a = hash_entry(a_, struct frame, text_elem);
+	const struct frame *b = hash_entry(b_, struct frame, text_elem);
+
+	if (a->text_inode != b->text_inode)
+		return a->text_inode < b->text_inode;
+	return a->text_ofs < b->text_ofs;
+}
+
+/* If PAGE is a page of a read-only executable segment that is not in
+ * memory, stores the inode and file offset it comes from. Such a page
+ * holds the same bytes in every process running that file. */
+static bool
+text_page_key(struct page *page, struct inode **inode, off_t *ofs)
+{
+	struct vma *vma = page->uninit.aux;
+
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		if (page->uninit.init == NULL || vma == NULL ||
+			!(vma->type & VM_SEGMENT) || vma->writable)
+			return false;
+		*inode = file_get_inode(vma->file);
+		*ofs = vma_page_ofs(vma, page->va);
+		return true;
+	case VM_FILE:
+		// 한 번 올라왔다가 쫓겨난 코드 페이지
+		if (page->frame != NULL || !page->file.segment)
+			return false;
+		*inode = file_get_inode(page->file.file);
+		*ofs = page->file.ofs;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Files the frame PAGE was just loaded into as the text frame for
+ * INODE at OFS, unless there already is one. */
+static void
+text_frame_add(struct page *page, struct inode *inode, off_t ofs)
+{
+	struct frame *frame;
+
+	lock_acquire(&frame_lock);
+	frame = page->frame;
+	if (frame != NULL && frame != &zero_frame && !(frame->state & FRAME_TEXT))
+	{
+		frame->text_inode = inode;
+		frame->text_ofs = ofs;
+		if (hash_insert(&text_frames, &frame->text_elem) == NULL)
+			frame->state |= FRAME_TEXT;
+	}
+	lock_release(&frame_lock);
+}
+
+/* Maps PAGE, a page of a read-only executable segment, to the frame
+ * another process already loaded from INODE at OFS, if there is one.
+ * The frame is then shared like a COW frame after fork. It stays
+ * evictable: eviction unmaps it from every process sharing it and
+ * drops it, and the next fault in any of them reads it in again and
+ * files it in text_frames anew. */
+static bool
+vm_map_text_page(struct page *page, struct inode *inode, off_t ofs)
+{
+	struct frame key, *frame;
+	struct hash_elem *e;
+	bool mapped;
+
+	key.text_inode = inode;
+	key.text_ofs = ofs;
+
+	// 찾은 프레임이 그사이 쫓겨나지 않도록 lock 을 잡은 채로 연결하고 매핑한다.
+	lock_acquire(&frame_lock);
+	e = hash_find(&text_frames, &key.text_elem);
+	if (e == NULL)
+	{
+		lock_release(&frame_lock);
+		return false;
+	}
+	frame = hash_entry(e, struct frame, text_elem);
+	if (frame->state & FRAME_EVICTING)
+	{
+		lock_release(&frame_lock);
+		return false;
+	}
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		page->uninit.page_initializer(page, page->uninit.type, frame->kva);
+	frame_link(frame, page);
+	mapped = pml4_set_page(page->owner->pml4, page->va, frame->kva, false);
+	lock_release(&frame_lock);
+
+	if (mapped)
+		text_share_cnt++;
+	return mapped;
+}
+
+/* Finds the file range PAGE is loaded from, if PAGE is not in memory
+ * and is either an uninit page made from a region (mmap and
+ * executable segments, see struct vma) or a swapped-out file page. */
+static bool
+fault_around_source(struct page *page, struct file **file, off_t *ofs,
+					uint32_t *read_bytes)
+{
+	if (page->frame != NULL)
+		return false;
+
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+	{
+		struct vma *vma = page->uninit.aux;
+		if (page->uninit.init == NULL || vma == NULL)
+			return false;
+		*file = vma->file;
+		*ofs = vma_page_ofs(vma, page->va);
+		*read_bytes = vma_page_read_bytes(vma, page->va);
+		return true;
+	}
+	case VM_FILE:
+		*file = page->file.file;
+		*ofs = page->file.ofs;
+		*read_bytes = page->file.read_bytes;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Fault-around: loads PAGE together with the pages that follow it
+ * in the same file, up to WINDOW pages, with one file read into a
+ * frame for each page, and maps all of them. Each frame comes from
+ * vm_get_frame(), so this evicts like a single fault would; the
+ * window stops short rather than push the process past its resident
+ * limit for the pages that follow. Returns false without mapping PAGE
+ * if PAGE is not file-backed, there is nothing to load along with it,
+ * or PAGE could not be mapped; the caller then falls back to
+ * vm_do_claim_page(). */
+static bool
+vm_fault_around_file(struct page *page, int window)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+	struct page *pages[VM_FAULT_AROUND_MAX];
+	struct frame *frames[VM_FAULT_AROUND_MAX];
+	void *kvas[VM_FAULT_AROUND_MAX];
+	uint32_t read_bytes[VM_FAULT_AROUND_MAX];
+	struct file *file;
+	off_t ofs, want;
+	size_t n, max, i;
+	bool mapped = false;
+
+	if (window <= 1 ||
+		!fault_around_source(page, &file, &ofs, &read_bytes[0]))
+		return false;
+
+	// 파일에서 바로 이어지는 페이지들만 모은다. 꽉 차지 않은 페이지가 나오면 거기까지.
+	// 뒤따르는 페이지 때문에 상주 한도를 넘기지는 않는다.
+	max = window < VM_FAULT_AROUND_MAX ? window : VM_FAULT_AROUND_MAX;
+	pages[0] = page;
+	for (n = 1; n < max && read_bytes[n - 1] == PGSIZE
+				&& (vm_rss_limit == 0 || spt->rss + n < (size_t)vm_rss_limit);
+		 n++)
+	{
+		struct page *next = vma_get_page(spt, page->va + n * PGSIZE);
+		struct file *next_file;
+		off_t next_ofs;
+
+		if (next == NULL ||
+			!fault_around_source(next, &next_file, &next_ofs, &read_bytes[n]) ||
+			next_file != file || next_ofs != ofs + (off_t)(n * PGSIZE))
+			break;
+		pages[n] = next;
+	}
+	if (n == 1)
+		return false;
+
+	// 프레임은 한 장씩 받고, 흩어진 프레임들로 명령 한 번에 읽는다.
+	for (i = 0; i < n; i++)
+	{
+		frames[i] = vm_get_frame();
+		kvas[i] = frames[i]->kva;
+	}
+	want = (n - 1) * PGSIZE + read_bytes[n - 1];
+	if (file_read_pages(file, kvas, want, ofs) != want)
+	{
+		for (i = 0; i < n; i++)
+			vm_free_frame(frames[i]);
+		return false;
+	}
+	memset((uint8_t *)kvas[n - 1] + read_bytes[n - 1], 0, PGSIZE - read_bytes[n - 1]);
+
+	for (i = 0; i < n; i++)
+	{
+		struct page *p = pages[i];
+		struct frame *frame = frames[i];
+		struct inode *inode;
+		off_t text_ofs;
+		bool text = text_page_key(p, &inode, &text_ofs);
+
+		lock_acquire(&frame_lock);
+		frame_link(frame, p);
+		lock_release(&frame_lock);
+
+		if (!pml4_set_page(p->owner->pml4, p->va, frame->kva, p->writable))
+		{
+			// 타입을 바꾸기 전이므로 페이지는 다음 fault 때 처음부터 읽으면 된다.
+			vm_unclaim_frame(p, frame);
+			continue;
+		}
+		// 내용은 이미 읽었으므로 init 은 부르지 않고 페이지 타입만 바꿔준다.
+		if (VM_TYPE(p->operations->type) == VM_UNINIT)
+			p->uninit.page_initializer(p, p->uninit.type, frame->kva);
+		frame_unpin(frame);
+		if (i == 0)
+			mapped = true;
+		else
+			around_cnt++;
+		if (text)
+			text_frame_add(p, inode, text_ofs);
+	}
+	return mapped;
+}
+
+/* Links PAGE to FRAME. The first page linked becomes frame->page,
+ * the one eviction looks at. Must hold frame_lock. */
+static void
+frame_link(struct frame *frame, struct page *page)
+{
+	struct supplemental_page_table *spt = &page->owner->spt;
+
+	if (frame->page == NULL)
+		frame->page = page;
+	list_push_back(&frame->pages, &page->share_elem);
+	frame->ref_cnt++;
+	page->frame = frame;
+	// zero_frame 은 누구의 resident set 에도 세지 않는다.
+	if (frame != &zero_frame && ++spt->rss > spt->rss_max)
+		spt->rss_max = spt->rss;
+}
+
+/* Unlinks PAGE from its frame and returns how many pages still share
+ * the frame. Must hold frame_lock. */
+static int
+frame_unlink(struct page *page)
+{
+	struct frame *frame = page->frame;
+
+	list_remove(&page->share_elem);
+	frame->ref_cnt--;
+	page->frame = NULL;
+	if (frame != &zero_frame)
+		page->owner->spt.rss--;
+	if (frame->page == page)
+		frame->page = frame->ref_cnt > 0
+						  ? list_entry(list_front(&frame->pages), struct page, share_elem)
+						  : NULL;
+	return frame->ref_cnt;
+}
+
+/* Takes the frame_table entry of KVA, a user page just handed out by
+ * palloc, into use with no pages linked. Must hold frame_lock. */
+static struct frame *
+frame_table_add(void *kva, bool pinned)
+{
+	struct frame *frame = &frame_table[palloc_user_index(kva)];
+
+	ASSERT(!(frame->state & FRAME_USED));
+
+	frame->page = NULL;
+	list_init(&frame->pages);
+	frame->ref_cnt = 0;
+	frame->hold_cnt = 0;
+	frame->ksm = KSM_NONE;
+	frame->ksm_sum = 0;
+	frame->state = FRAME_USED | (pinned ? FRAME_PINNED : 0);
+	frame->stamp = ++frame_stamp;
+	frame_used_cnt++;
+	return frame;
+}
+
+/* Takes FRAME out of use and out of ksmd's tables. Its page goes back
+ * to palloc separately, after this. Must hold frame_lock. */
+static void
+frame_table_remove(struct frame *frame)
+{
+	ASSERT(frame->state & FRAME_USED);
+
+	ksm_forget(frame);
+	if (frame->state & FRAME_TEXT)
+		hash_delete(&text_frames, &frame->text_elem);
+	frame->state = 0;
+	frame_used_cnt--;
+}
+
+/* Lets eviction and ksmd look at FRAME again once its contents are
+ * filled in. */
+static void
+frame_unpin(struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	frame->state &= ~FRAME_PINNED;
+	lock_release(&frame_lock);
+}
+
+/* Takes FRAME out of use and gives its memory back to the user pool.
+ * No page may be linked to FRAME. */
+static void
+vm_free_frame(struct frame *frame)
+{
+	ASSERT(frame->ref_cnt == 0);
+
+	lock_acquire(&frame_lock);
+	frame_table_remove(frame);
+	lock_release(&frame_lock);
+
+	palloc_free_page(frame->kva);
+}
+
+/* Unlinks PAGE from FRAME, the pinned frame from vm_get_frame() it
+ * was just linked to, after filling or mapping it failed, and frees
+ * FRAME. PAGE is left as not in memory. */
+static void
+vm_unclaim_frame(struct page *page, struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	frame_unlink(page);
+	lock_release(&frame_lock);
+	vm_free_frame(frame);
+}
+
+/* Unmaps PAGE and drops its reference to its frame, which the caller
+ * holds (frame_hold). The frame is freed once no other page shares
+ * it. */
+void vm_put_frame(struct page *page)
+{
+	struct frame *frame;
+	int ref_cnt;
+
+	lock_acquire(&frame_lock);
+	frame = page->frame;
+	if (frame == NULL)
+	{
+		lock_release(&frame_lock);
+		return;
+	}
+	frame->hold_cnt--;
+	ref_cnt = frame_unlink(page);
+	lock_release(&frame_lock);
+
+	if (page->owner->pml4 != NULL)
+		pml4_clear_page(page->owner->pml4, page->va);
+
+	if (ref_cnt == 0 && frame != &zero_frame)
+		vm_free_frame(frame);
+}
+
+/* Growing the stack. */
+static void
+vm_stack_growth(void *addr UNUSED)
+{
+	// printf("vm_stac-growth 해야햄\n");
+	// 하나 이상의 anonymous 페이지를 할당하여 스택 크기를 늘립니다. 이로써 addr은 faulted 주소(폴트가 발생하는 주소) 에서 유효한 주소가 됩니다.
+	// 페이지를 할당할 때는 주소를 PGSIZE 기준으로 내림하세요.
+	// void *new_page = vm_get_frame();
+	// if (new_page == NULL)
+	// {
+	// 	return false;
+	// }
+	// pml4_set_page(thread_current()->pml4, addr, new_page, 1);
+	// // fault handler 에서 필요할때 호출하도록 수정하기.
+	return vm_alloc_page(VM_ANON, addr, 1);
+}
+
+/* Handle the fault on write_protected page */
+// fork 후 read-only 로 공유 중인 페이지에 처음 쓰는 경우. 아직 다른 페이지와
+// 공유 중이면 새 프레임에 복사해서 떼어내고, 마지막 남은 페이지라면 쓰기 권한만 돌려준다.
+// zero_frame 은 참조가 몇 개든 항상 새 프레임을 받는다 (새 프레임은 이미 0).
+static bool
+vm_handle_wp(struct page *page UNUSED)
+{
+	struct frame *old;
+	struct frame *new;
+	uint64_t *pml4 = page->owner->pml4;
+	bool success;
+
+	// PTE 는 frame_lock 을 잡은 채로 고친다. 그래야 ksmd 가 사이에 끼어들어
+	// 쓰기를 막아둔 매핑을 다시 쓰기 가능으로 덮어쓰지 않는다.
+	lock_acquire(&frame_lock);
+	old = frame_wait_io(page);
+	if (old == NULL)
+	{
+		// 그사이 쫓겨났다. 다시 fault 가 나면 읽어 온다.
+		lock_release(&frame_lock);
+		return true;
+	}
+	if (old->ref_cnt == 1 && old != &zero_frame)
+	{
+		// 곧 내용이 바뀌므로 ksmd 의 테이블에서 뺀다.
+		ksm_forget(old);
+		success = pml4_set_page(pml4, page->va, old->kva, true);
+		lock_release(&frame_lock);
+		return success;
+	}
+	// 새 프레임을 받는 동안 old 가 evict 되지 않도록 잡아둔다.
+	old->hold_cnt++;
+	lock_release(&frame_lock);
+
+	new = vm_get_frame();
+
+	lock_acquire(&frame_lock);
+	old->hold_cnt--;
+	if (old->ref_cnt == 1 && old != &zero_frame)
+	{
+		// 기다리는 동안 다른 페이지들이 모두 떨어져 나갔다.
+		ksm_forget(old);
+		success = pml4_set_page(pml4, page->va, old->kva, true);
+		lock_release(&frame_lock);
+		vm_free_frame(new);
+		return success;
+	}
+	if (old == &zero_frame)
+		zero_fill_cnt++;
+	else
+	{
+		memcpy(new->kva, old->kva, PGSIZE);
+		if (old->ksm == KSM_STABLE)
+			ksm_unmerge_cnt++;
+		else
+			cow_cnt++;
+	}
+	frame_unlink(page);
+	frame_link(new, page);
+	success = pml4_set_page(pml4, page->va, new->kva, true);
+	new->state &= ~FRAME_PINNED;
+	lock_release(&frame_lock);
+	return success;
+}
+
+/* Returns the checksum a frame is filed under in ksmd's tables. */
+static uint64_t
+ksm_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	return hash_entry(e, struct frame, ksm_elem)->ksm_sum;
+}
+
+static bool
+ksm_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED)
+{
+	return hash_entry(a, struct frame, ksm_elem)->ksm_sum <
+		   hash_entry(b, struct frame, ksm_elem)->ksm_sum;
+}
+
+static void
+ksm_unstable_drop(struct hash_elem *e, void *aux UNUSED)
+{
+	hash_entry(e, struct frame, ksm_elem)->ksm = KSM_NONE;
+}
+
+/* Sets up the merge tables and starts ksmd if "-ksm" was given. */
+static void
+vm_ksm_init(void)
+{
+	hash_init(&ksm_stable, ksm_hash, ksm_less, NULL);
+	hash_init(&ksm_unstable, ksm_hash, ksm_less, NULL);
+	ksm_cursor = 0;
+	zero_sum = hash_bytes(zero_frame.kva, PGSIZE);
+	if (vm_ksm && vm_ksm_rate > 0)
+		thread_create("ksmd", PRI_DEFAULT, vm_ksmd, NULL);
+	else
+		vm_ksm = false;
+}
+
+/* Removes FRAME from whichever ksmd table it is in. Must hold frame_lock. */
+static void
+ksm_forget(struct frame *frame)
+{
+	if (frame->ksm == KSM_STABLE)
+		hash_delete(&ksm_stable, &frame->ksm_elem);
+	else if (frame->ksm == KSM_UNSTABLE)
+		hash_delete(&ksm_unstable, &frame->ksm_elem);
+	frame->ksm = KSM_NONE;
+}
+
+/* Returns the frame in table H filed under SUM, or NULL. */
+static struct frame *
+ksm_lookup(struct hash *h, uint64_t sum)
+{
+	struct frame key;
+	struct hash_elem *e;
+
+	key.ksm_sum = sum;
+	e = hash_find(h, &key.ksm_elem);
+	return e != NULL ? hash_entry(e, struct frame, ksm_elem) : NULL;
+}
+
+/* Maps every page linked to FRAME read-only. A write then faults into
+ * vm_handle_wp(), which has to take frame_lock first. */
+static void
+ksm_write_protect(struct frame *frame)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *p = list_entry(e, struct page, share_elem);
+		pml4_set_page(p->owner->pml4, p->va, frame->kva, false);
+	}
+}
+
+/* Moves the only page of FRAME over to TARGET, which holds the same
+ * bytes, and frees FRAME. Must hold frame_lock. */
+static void
+ksm_merge(struct frame *frame, struct frame *target)
+{
+	struct page *page = frame->page;
+
+	frame_unlink(page);
+	frame_link(target, page);
+	pml4_set_page(page->owner->pml4, page->va, target->kva, false);
+
+	frame_table_remove(frame);
+	palloc_free_page(frame->kva);
+	ksm_merge_cnt++;
+}
+
+/* Returns true if FRAME holds a private, mapped anon page that ksmd
+ * may merge. Must hold frame_lock. */
+static bool
+ksm_candidate(const struct frame *frame)
+{
+	struct page *page = frame->page;
+
+	return frame_evictable(frame) && frame->ref_cnt == 1 &&
+		   VM_TYPE(page->operations->type) == VM_ANON && !page->anon.readahead;
+}
+
+/* Looks at one frame for ksmd. A private, mapped anon frame whose
+ * checksum did not change since the last pass is merged into a
+ * stable frame or zero_frame with the same bytes, or into a frame
+ * seen earlier in this pass, which then becomes stable. Otherwise it
+ * is remembered as a candidate for the rest of the pass.
+ * frame_lock is only held to look at the frames and the tables: the
+ * checksum and the comparison run without it. Afterwards the frames
+ * are checked again (same stamp, same ksm state), so that a frame
+ * evicted, freed or written meanwhile is left alone. */
+static void
+ksm_scan_frame(struct frame *frame)
+{
+	struct frame *target;
+	uint64_t stamp, target_stamp, sum;
+	uint8_t target_ksm;
+	bool same;
+
+	lock_acquire(&frame_lock);
+	if (!ksm_candidate(frame) || frame->ksm != KSM_NONE)
+	{
+		lock_release(&frame_lock);
+		return;
+	}
+	stamp = frame->stamp;
+	lock_release(&frame_lock);
+
+	ksm_scan_cnt++;
+	// 지난번 checksum 과 다르면 자주 쓰는 페이지로 보고 이번에는 건너뛴다.
+	sum = hash_bytes(frame->kva, PGSIZE);
+
+	lock_acquire(&frame_lock);
+	if (frame->stamp != stamp || !ksm_candidate(frame) || frame->ksm != KSM_NONE)
+		goto done;
+	if (sum != frame->ksm_sum)
+	{
+		frame->ksm_sum = sum;
+		goto done;
+	}
+
+	if (sum == zero_sum)
+		target = &zero_frame;
+	else if ((target = ksm_lookup(&ksm_stable, sum)) == NULL &&
+			 (target = ksm_lookup(&ksm_unstable, sum)) == NULL)
+	{
+		frame->ksm = KSM_UNSTABLE;
+		hash_insert(&ksm_unstable, &frame->ksm_elem);
+		goto done;
+	}
+	// zero_frame 은 늘 고정되어 있고 page 도 없지만 내용이 바뀌지 않으므로 합쳐도 된다.
+	if (target != &zero_frame && ((target->state & FRAME_PINNED) || target->page == NULL))
+		goto done;
+
+	// 쓰기를 먼저 막고 비교해야 비교한 뒤에 내용이 바뀌지 않는다. 그사이 쓰기가
+	// 오면 vm_handle_wp() 의 ksm_forget() 이 ksm 을 KSM_NONE 으로 돌려 놓는다.
+	ksm_write_protect(frame);
+	frame->ksm = KSM_PENDING;
+	if (target->ksm == KSM_UNSTABLE)
+		ksm_write_protect(target);
+	target_stamp = target->stamp;
+	target_ksm = target->ksm;
+	lock_release(&frame_lock);
+
+	same = !memcmp(frame->kva, target->kva, PGSIZE);
+
+	lock_acquire(&frame_lock);
+	if (frame->stamp != stamp || frame->ksm != KSM_PENDING)
+		goto done;
+	frame->ksm = KSM_NONE;
+	if (!same || !ksm_candidate(frame) || target->stamp != target_stamp ||
+		target->ksm != target_ksm ||
+		(target != &zero_frame && ((target->state & FRAME_PINNED) || target->page == NULL)))
+		goto done;
+
+	if (target->ksm == KSM_UNSTABLE)
+	{
+		hash_delete(&ksm_unstable, &target->ksm_elem);
+		target->ksm = KSM_STABLE;
+		hash_insert(&ksm_stable, &target->ksm_elem);
+	}
+	ksm_merge(frame, target);
+done:
+	lock_release(&frame_lock);
 }
 
-/* Get the type of the page. This function is useful if you want to know the
- * type of the page after it will be initialized.
- * This function is fully implemented now. */
-enum vm_type
-page_get_type(struct page *page)
+/* Kernel thread for same-page merging. Every KSM_PASS_TICKS it
+ * checksums the next vm_ksm_rate frames in use in frame_table. After each full
+ * sweep the unstable candidates are dropped, since they stayed
+ * writable and may no longer match their checksums. frame_lock is
+ * taken for each frame separately, so faults get in between. */
+static void
+vm_ksmd(void *aux UNUSED)
 {
-	int ty = VM_TYPE(page->operations->type);
-	switch (ty)
+	for (;;)
 	{
-	case VM_UNINIT:
-		return VM_TYPE(page->uninit.type);
-	default:
-		return ty;
+		timer_sleep(KSM_PASS_TICKS);
+
+		// 빈 항목은 세지 않지만, 한 번에 테이블 한 바퀴보다 많이 돌지는 않는다.
+		for (size_t i = 0, seen = 0; seen < (size_t)vm_ksm_rate && i < frame_table_cnt; i++)
+		{
+			struct frame *frame;
+			bool used;
+
+			lock_acquire(&frame_lock);
+			if (ksm_cursor >= frame_table_cnt)
+			{
+				hash_clear(&ksm_unstable, ksm_unstable_drop);
+				ksm_cursor = 0;
+			}
+			frame = &frame_table[ksm_cursor++];
+			used = frame->state & FRAME_USED;
+			lock_release(&frame_lock);
+			if (used)
+			{
+				ksm_scan_frame(frame);
+				seen++;
+			}
+		}
 	}
 }
 
-/* Helpers */
-static struct frame *vm_get_victim(void);
-static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+/* Starts flushd unless "-flush-rate=0" was given. */
+static void
+vm_flush_init(void)
+{
+	flush_cursor = 0;
+	if (vm_flush_rate > 0)
+		thread_create("flushd", PRI_DEFAULT, vm_flushd, NULL);
+}
 
-/* Create the pending page object with initializer. If you want to create a
- * page, do not create it directly and make it through this function or
- * `vm_alloc_page`. */
-// pending 중인 페이지 객체를 초기화하고 생성합니다.
-// 페이지를 생성하려면 직접 생성하지 말고 이 함수나 vm_alloc_page를 통해 만드세요.
-// init과 aux는 첫 page fault가 발생할 때 호출된다.
-bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writable,
-									vm_initializer *init, void *aux)
+/* Returns true if FRAME holds an mmap page that no one else is
+ * filling, evicting or writing back. Must hold frame_lock. */
+static bool
+frame_is_mmap(const struct frame *frame)
 {
-	ASSERT(VM_TYPE(type) != VM_UNINIT)
+	struct page *page = frame->page;
 
-	struct supplemental_page_table *spt = &thread_current()->spt;
+	return (frame->state & (FRAME_USED | FRAME_PINNED)) == FRAME_USED
+		   && page != NULL && VM_TYPE(page->operations->type) == VM_FILE
+		   && !page->file.segment;
+}
 
-	/* Check wheter the upage is already occupied or not. */
-	// upage가 이미 사용 중인지 확인합니다.
-	if (spt_find_page(spt, upage) == NULL)
+/* Returns true if any page linked to FRAME was written since it was
+ * last written back, and clears the dirty bit of every one of them.
+ * A frame shared after fork has one dirty bit in each sharer's pml4.
+ * Must hold frame_lock. */
+static bool
+frame_test_and_clear_dirty(struct frame *frame)
+{
+	bool dirty = false;
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
 	{
-		/* : Create the page, fetch the initialier according to the VM type,
-		 * : and then create "uninit" page struct by calling uninit_new. You
-		 * : should modify the field after calling the uninit_new. */
-		// 페이지를 생성하고,
-		struct page *p = (struct page *)malloc(sizeof(struct page));
-		// VM 유형에 따라 초기화 함수를 가져와서
-		//// 함수 포인터방식.. 함수 자체가 주소값을 가지고있기 때문에 이름만 넘기면 된다.
-		bool (*page_initializer)(struct page *, enum vm_type, void *);
+		struct page *p = list_entry(e, struct page, share_elem);
+		uint64_t *pml4 = p->owner->pml4;
 
-		switch (VM_TYPE(type))
+		if (pml4 != NULL && pml4_is_dirty(pml4, p->va))
 		{
-		case VM_ANON:
-			page_initializer = anon_initializer;
-			break;
-		case VM_FILE:
-			page_initializer = file_backed_initializer;
-			break;
+			pml4_set_dirty(pml4, p->va, false);
+			dirty = true;
 		}
-		// uninit_new를 호출해 "uninit" 페이지 구조체를 생성하세요.
-		uninit_new(p, upage, init, type, aux, page_initializer);
-		// uninit_new를 호출한 후에는 필드를 수정해야 합니다.
-		p->writable = writable;
-
-		/* : Insert the page into the spt. */
-		// printf("여기까지 와?\n");
-		return spt_insert_page(spt, p);
 	}
-err:
-	return false;
+	return dirty;
 }
 
-/* Find VA from spt and return page. On error, return NULL. */
-// spt에서 va에 해당하는 page를 찾아서 반환
-struct page *
-spt_find_page(struct supplemental_page_table *spt UNUSED, void *va UNUSED)
+/* Marks FRAME as being written back: it is pinned, so that eviction
+ * and ksmd leave it alone, and everyone who would unlink, free or
+ * remap one of its pages waits in frame_wait_io() until
+ * frame_end_writeback(). Its pages stay mapped, so their owners keep
+ * running; a store during the write only makes the page dirty again.
+ * Must hold frame_lock. */
+static void
+frame_start_writeback(struct frame *frame)
 {
-	struct page *page = NULL;
-	page = (struct page *)malloc(sizeof(struct page));
-	struct hash_elem *e;
-
-	// va에 해당하는 hash_elem 찾기
-	page->va = pg_round_down(va); // page의 시작 주소 할당
-	e = hash_find(&spt->spt_hash, &page->hash_elem);
-	free(page);
+	frame->state |= FRAME_PINNED | FRAME_WRITEBACK;
+}
 
-	// 있으면 e에 해당하는 페이지 반환
-	return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
+/* Ends the writeback of FRAME started by frame_start_writeback(). Must
+ * hold frame_lock. */
+static void
+frame_end_writeback(struct frame *frame)
+{
+	frame->state &= ~(FRAME_PINNED | FRAME_WRITEBACK);
+	cond_broadcast(&io_cond, &frame_lock);
 }
 
-/* Insert PAGE into spt with validation. */
-bool spt_insert_page(struct supplemental_page_table *spt UNUSED,
-					 struct page *page UNUSED)
+/* Orders mmap pages by file, then by offset in the file. */
+static bool
+flush_less(const struct page *a, const struct page *b)
 {
+	struct inode *ia = file_get_inode(a->file.file);
+	struct inode *ib = file_get_inode(b->file.file);
 
-	return hash_insert(&spt->spt_hash, &page->hash_elem) == NULL ? true : false; // 존재하지 않을 경우에만 삽입
+	if (ia != ib)
+		return (uintptr_t)ia < (uintptr_t)ib;
+	return a->file.ofs < b->file.ofs;
 }
 
-void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
+/* Kernel thread for dirty mmap writeback. Every FLUSH_PASS_TICKS it
+ * picks up to vm_flush_rate dirty mmap frames from the next part of
+ * frame_table and writes them back sorted by file and offset, so that
+ * pages of one file go out in order. The frames are marked with
+ * frame_start_writeback() while frame_lock is held, and the writes are
+ * done without it. */
+static void
+vm_flushd(void *aux UNUSED)
 {
-	vm_dealloc_page(page);
-	return true;
+	struct page *batch[FLUSH_BATCH_MAX];
+	size_t max = vm_flush_rate < FLUSH_BATCH_MAX ? vm_flush_rate : FLUSH_BATCH_MAX;
+
+	for (;;)
+	{
+		size_t n = 0;
+
+		timer_sleep(FLUSH_PASS_TICKS);
+
+		lock_acquire(&frame_lock);
+		for (size_t i = 0; n < max && i < frame_table_cnt; i++)
+		{
+			struct frame *frame;
+
+			if (flush_cursor >= frame_table_cnt)
+				flush_cursor = 0;
+			frame = &frame_table[flush_cursor++];
+			if (frame_is_mmap(frame) && frame_test_and_clear_dirty(frame))
+			{
+				frame_start_writeback(frame);
+				batch[n++] = frame->page;
+			}
+		}
+		lock_release(&frame_lock);
+
+		// 많아야 FLUSH_BATCH_MAX 개이므로 삽입 정렬로 충분하다.
+		for (size_t i = 1; i < n; i++)
+		{
+			struct page *page = batch[i];
+			size_t j = i;
+
+			for (; j > 0 && flush_less(page, batch[j - 1]); j--)
+				batch[j] = batch[j - 1];
+			batch[j] = page;
+		}
+		// 쓰는 동안 batch 의 페이지는 떼어지지도, 해제되지도 않는다.
+		for (size_t i = 0; i < n; i++)
+			file_backed_write(batch[i]);
+
+		lock_acquire(&frame_lock);
+		for (size_t i = 0; i < n; i++)
+			frame_end_writeback(batch[i]->frame);
+		flush_cnt += n;
+		lock_release(&frame_lock);
+	}
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *
-vm_get_victim(void)
+/* Writes PAGE back to its file now if it is a dirty mmap page of the
+ * current process (msync()). A page still shared with a child after
+ * fork is written if any sharer dirtied it, since they all hold the
+ * same contents. Returns true if it wrote. */
+bool vm_sync_page(struct page *page)
 {
-	struct frame *victim = list_entry(list_pop_front(&frame_list), struct frame, frame_elem);
+	struct frame *frame;
 
-	return victim;
+	ASSERT(page->owner == thread_current());
+
+	if (VM_TYPE(page->operations->type) != VM_FILE || page->file.segment)
+		return false;
+	lock_acquire(&frame_lock);
+	// flushd 나 eviction 이 쓰고 있으면 끝날 때까지 기다린다.
+	frame = frame_wait_io(page);
+	if (frame == NULL || !frame_test_and_clear_dirty(frame))
+	{
+		lock_release(&frame_lock);
+		return false;
+	}
+	frame_start_writeback(frame);
+	lock_release(&frame_lock);
+
+	file_backed_write(page);
+
+	lock_acquire(&frame_lock);
+	frame_end_writeback(frame);
+	msync_cnt++;
+	lock_release(&frame_lock);
+	return true;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
-// 페이지를 배신..하고 다른데 가서 달라붙음.
-//  palloc 해서 NULL 이 나오는 경우, 다른 프레임 떼와서 붙여주기.
-//  전\체프레임 frame list, elem 으로 연결관리
-//  swap table 은 anony에만 필요.
-//  file은
-static struct frame *
-vm_evict_frame(void)
+/* Sets up the madvise(WILLNEED) queue and starts prefetchd. */
+static void
+vm_prefetch_init(void)
 {
-	struct frame *victim UNUSED = vm_get_victim();
-	// NOTE - 페이지가, file-backed냐, anon이냐에 따라서 호출되는 하ㅏㅁ수가 달라짐.
-	// anonymous 인 경우, 디스크에[ backing store가 따로 없기 때문에 만들어 줘야 함.
-	swap_out(victim->page);
-	// memset(victim->kva, 0, PGSIZE);
-	return victim;
+	list_init(&prefetch_queue);
+	lock_init(&prefetch_lock);
+	sema_init(&prefetch_sema, 0);
+	thread_create("prefetchd", PRI_DEFAULT, vm_prefetchd, NULL);
 }
 
-/* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
-// vm_try_handle_fault 에서, vm_clain_page가 불리는 경우는 스택을 늘려줘서 해결되는 것이 아닌 다른 경우
-// 의 fault 가 난 주소에 대해서, 페이지와 물리 프레임을 연결시켜주기 위해서
-// 이떄 물리 프레임을 연결시켜주려면, 빈 프레임을 찾아야 하는데, 이를 담당하는 함수 = vm_get_frame()
-static struct frame *
-vm_get_frame(void)
+/* Queues the pages of SPT in START...END (END excluded) for prefetchd.
+ * SPT must be the current thread's and already hold struct pages for
+ * the range. Out of memory, the request is dropped; it is only a hint. */
+void vm_prefetch(struct supplemental_page_table *spt, void *start, void *end)
 {
-	struct frame *frame = NULL;
+	struct prefetch *req = malloc(sizeof *req);
 
-	void *kva = palloc_get_page(PAL_USER | PAL_ZERO); // user pool에서 새로운 physical page를 가져온다.
+	ASSERT(spt == &thread_current()->spt);
 
-	// if (kva == NULL)		   // page 할당 실패 -> 나중에 swap_out 처리
-	// 	swap_out(frame->page); // OS를 중지시키고, 소스 파일명, 라인 번호, 함수명 등의 정보와 함께 사용자 지정 메시지를 출력
+	if (req == NULL)
+		return;
+	req->spt = spt;
+	req->next = start;
+	req->end = end;
+	lock_acquire(&prefetch_lock);
+	list_push_back(&prefetch_queue, &req->elem);
+	spt->prefetch_cnt++;
+	lock_release(&prefetch_lock);
+	sema_up(&prefetch_sema);
+}
 
-	if (!kva)
-	{
+/* Drops the requests of SPT that prefetchd has not finished. Once it
+ * returns, prefetchd no longer touches SPT's pages, so they may be
+ * freed. */
+void vm_prefetch_cancel(struct supplemental_page_table *spt)
+{
+	struct list_elem *e;
 
-		frame = vm_evict_frame();
+	// 요청을 내는 것도 주인뿐이므로 0이면 볼 것이 없다.
+	if (spt->prefetch_cnt == 0)
+		return;
+	lock_acquire(&prefetch_lock);
+	for (e = list_begin(&prefetch_queue); e != list_end(&prefetch_queue);)
+	{
+		struct prefetch *req = list_entry(e, struct prefetch, elem);
 
-		list_push_back(&frame_list, &frame->frame_elem);
-		return frame;
+		e = list_next(e);
+		if (req->spt != spt)
+			continue;
+		// 세마포어 값은 prefetchd 가 빈 큐를 보고 넘어가면서 맞춰진다.
+		list_remove(&req->elem);
+		free(req);
 	}
-	else
+	spt->prefetch_cnt = 0;
+	lock_release(&prefetch_lock);
+}
+
+/* Reads PAGE into a frame of its own without mapping it, for
+ * prefetchd. Pages already in memory, and fresh anonymous pages,
+ * which have nothing to read, are skipped. Must hold prefetch_lock. */
+static void
+vm_prefetch_page(struct page *page)
+{
+	struct frame *frame;
+	struct inode *inode;
+	off_t ofs;
+	bool text = text_page_key(page, &inode, &ofs);
+
+	// page->frame 이 NULL 에서 바뀌는 것은 주인의 fault 뿐인데, 그것은 prefetch_lock 뒤에서 기다린다.
+	if (page->frame != NULL || is_fresh_anon(page))
+		return;
+	frame = vm_get_frame();
+	lock_acquire(&frame_lock);
+	frame_link(frame, page);
+	lock_release(&frame_lock);
+	if (!swap_in(page, frame->kva))
 	{
-		frame = (struct frame *)malloc(sizeof(struct frame)); // 프레임 할당
-		frame->kva = kva;									  // 프레임 멤버 초기화
-		frame->page = NULL;
-		list_push_back(&frame_list, &frame->frame_elem);
+		// 읽지 못했으면 프레임을 돌려준다. 주인이 fault 를 내면 다시 읽어 본다.
+		lock_acquire(&frame_lock);
+		frame_hold(page);
+		frame->state &= ~FRAME_PINNED;
+		lock_release(&frame_lock);
+		vm_put_frame(page);
+		return;
 	}
-	ASSERT(frame != NULL);
-	ASSERT(frame->page == NULL);
+	frame_unpin(frame);
+	if (text)
+		text_frame_add(page, inode, ofs);
+	prefetch_cnt++;
+}
 
-	return frame;
-	// palloc 으로 공간을 받오울 수가 없다면 => frame -> kva == NULL 이라면, evict를 통해 프레임을 차지하고있는 페이지를 쫓아내야 한다.
+/* Kernel thread for madvise(WILLNEED). Takes the queued requests in
+ * order and reads their pages one at a time, holding prefetch_lock for
+ * each page so that the owner can cancel or fault in between. */
+static void
+vm_prefetchd(void *aux UNUSED)
+{
+	for (;;)
+	{
+		struct prefetch *req;
+		struct page *page;
+
+		sema_down(&prefetch_sema);
+		lock_acquire(&prefetch_lock);
+		while (!list_empty(&prefetch_queue))
+		{
+			req = list_entry(list_front(&prefetch_queue), struct prefetch, elem);
+			if (req->next >= req->end)
+			{
+				list_remove(&req->elem);
+				req->spt->prefetch_cnt--;
+				free(req);
+				break;
+			}
+			page = spt_find_page(req->spt, req->next);
+			req->next += PGSIZE;
+			if (page != NULL)
+				vm_prefetch_page(page);
+			// 페이지마다 lock 을 놓아서 주인의 fault 와 취소가 끼어들 수 있게 한다.
+			lock_release(&prefetch_lock);
+			lock_acquire(&prefetch_lock);
+		}
+		lock_release(&prefetch_lock);
+	}
 }
 
-/* Growing the stack. */
+/* SEQUENTIAL 로 읽는 영역에서 VA 바로 앞 페이지들의 프레임을 FRAME_COLD 로
+ * 표시한다. 다시 읽지 않을 것이므로 eviction 이 가장 먼저 가져간다. 이미
+ * 표시된 프레임을 만나면 그 앞은 지난번에 표시한 것이다. */
 static void
-vm_stack_growth(void *addr UNUSED)
+vm_drop_behind(struct supplemental_page_table *spt, struct vma *vma, uint8_t *va)
 {
-	// printf("vm_stac-growth 해야햄\n");
-	// 하나 이상의 anonymous 페이지를 할당하여 스택 크기를 늘립니다. 이로써 addr은 faulted 주소(폴트가 발생하는 주소) 에서 유효한 주소가 됩니다.
-	// 페이지를 할당할 때는 주소를 PGSIZE 기준으로 내림하세요.
-	// void *new_page = vm_get_frame();
-	// if (new_page == NULL)
-	// {
-	// 	return false;
-	// }
-	// pml4_set_page(thread_current()->pml4, addr, new_page, 1);
-	// // fault handler 에서 필요할때 호출하도록 수정하기.
-	return vm_alloc_page(VM_ANON, addr, 1);
+	lock_acquire(&frame_lock);
+	for (int i = 0; i < VM_FAULT_AROUND_MAX && va > vma->start; i++)
+	{
+		struct page *page;
+		struct frame *frame;
+
+		va -= PGSIZE;
+		page = spt_find_page(spt, va);
+		if (page == NULL || (frame = page->frame) == NULL || frame == &zero_frame)
+			continue;
+		if (frame->state & FRAME_COLD)
+			break;
+		if (frame->ref_cnt == 1)
+		{
+			// 읽고 지나가면서 켜진 accessed 비트가 second chance 를 주지 않게 끈다.
+			pml4_set_accessed(page->owner->pml4, va, false);
+			frame->state |= FRAME_COLD;
+		}
+	}
+	lock_release(&frame_lock);
 }
 
-/* Handle the fault on write_protected page */
+/* Returns what a not-present fault on PAGE needs, for the fault
+ * statistics of exception.c. */
+static enum fault_cause
+fault_cause_of(struct page *page)
+{
+	switch (VM_TYPE(page->operations->type))
+	{
+	case VM_UNINIT:
+		return is_fresh_anon(page) ? FAULT_ZERO : FAULT_UNINIT;
+	case VM_ANON:
+		return FAULT_SWAP;
+	default:
+		return FAULT_FILE;
+	}
+}
+
+/* Brings PAGE, which the current thread faulted on, into memory and
+ * maps it, by the cheapest way that applies. VMA is the region of
+ * PAGE or NULL; its advice sets the fault-around window. */
 static bool
-vm_handle_wp(struct page *page UNUSED)
+vm_fault_in(struct page *page, struct vma *vma, bool write)
 {
+	enum vma_advice advice = vma != NULL ? vma->advice : VMA_NORMAL;
+	struct inode *inode;
+	off_t ofs;
+	bool text;
+
+	// 2 MiB 구간 전체가 새 anon 페이지면 한 번에 큰 페이지로 매핑한다.
+	if (vm_map_huge_anon(page))
+		return true;
+	// 새 anon 페이지를 읽기만 하는 경우 프레임을 받지 않고 zero_frame 을 보여준다.
+	if (!write && vm_map_zero_page(page))
+		return true;
+	// 같은 실행 파일을 돌리는 프로세스가 이미 읽어 둔 코드 페이지면 그 프레임을 같이 쓴다.
+	text = text_page_key(page, &inode, &ofs);
+	if (text && vm_map_text_page(page, inode, ofs))
+		return true;
+	// swap readahead 나 madvise(WILLNEED) 로 이미 메모리에 올라와 있으면 매핑만 해준다.
+	if (vm_map_cached_page(page))
+		return true;
+	// 파일에서 읽어오는 페이지면 뒤따르는 페이지들까지 한 번에 읽어서 매핑한다.
+	if (advice != VMA_RANDOM &&
+		vm_fault_around_file(page, advice == VMA_SEQUENTIAL ? VM_FAULT_AROUND_MAX
+															: vm_fault_around))
+		return true;
+	if (!vm_do_claim_page(page))
+		return false;
+	if (text)
+		text_frame_add(page, inode, ofs);
+	return true;
 }
 
 /* Return true on success */
@@ -239,11 +2088,16 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 {
 	struct supplemental_page_table *spt UNUSED = &thread_current()->spt;
 	struct page *page = NULL;
+	struct vma *vma;
+	bool prefetching, success;
+
+	fault_cnt++;
 	if (addr == NULL)
 		return false;
 
 	if (is_kernel_vaddr(addr))
 		return false;
+	spt_count_fault(spt);
 
 	// 접근하려는 주소가 현재 스택 포인터보다 아래 있고, 그 차이가 한 페이지 내라면, 스택증가.
 	// printf("🥰%d %d \n", addr, f->rsp);
@@ -254,19 +2108,42 @@ bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
 		//  stack growth
 		// printf("조건 드루와\n");
 		vm_stack_growth(pg_round_down(addr));
+		thread_current()->fault_cause = FAULT_STACK;
 		// return true;
 	}
 
 	if (not_present) // 접근한 메모리의 physical page가 존재하지 않은 경우
 	{
 		/* : Validate the fault */
-		page = spt_find_page(spt, addr);
+		// mmap 영역과 실행 파일 세그먼트의 페이지는 여기서 처음 만들어진다.
+		page = vma_get_page(spt, addr);
 		if (page == NULL)
 			return false;
 		if (write == 1 && page->writable == 0) // write 불가능한 페이지에 write 요청한 경우
 			return false;
 
-		return vm_do_claim_page(page);
+		if (thread_current()->fault_cause != FAULT_STACK)
+			thread_current()->fault_cause = fault_cause_of(page);
+		// prefetchd 가 이 프로세스의 페이지를 읽고 있을 수 있으면 그 사이에 끼어들지 않는다.
+		vma = vma_find(spt, addr);
+		prefetching = spt->prefetch_cnt > 0;
+		if (prefetching)
+			lock_acquire(&prefetch_lock);
+		success = vm_fault_in(page, vma, write);
+		if (prefetching)
+			lock_release(&prefetch_lock);
+		if (success && vma != NULL && vma->advice == VMA_SEQUENTIAL)
+			vm_drop_behind(spt, vma, page->va);
+		return success;
+	}
+
+	if (write) // 공유(COW) 중이라 read-only 로 매핑된 페이지에 쓰기
+	{
+		page = spt_find_page(spt, addr);
+		if (page == NULL || !page->writable)
+			return false;
+		thread_current()->fault_cause = FAULT_COW;
+		return vm_handle_wp(page);
 	}
 
 	return false;
@@ -299,13 +2176,10 @@ vm_do_claim_page(struct page *page)
 	struct frame *frame = vm_get_frame();
 
 	/* Set links */
-	frame->page = page;
-	page->frame = frame;
+	lock_acquire(&frame_lock);
+	frame_link(frame, page);
+	lock_release(&frame_lock);
 
-	/* : Insert page table entry to map page's VA to frame's PA. */
-	// 가상 주소와 물리 주소를 매핑
-	struct thread *current = thread_current();
-	pml4_set_page(current->pml4, page->va, frame->kva, page->writable);
 	// page_oprations 의 swap_in이 호출됨 -> uninit_initailze가 호출되면서 uninit페이지의 초기화가 이루어진다.
 	/*
 	static const struct page_oprations uninit_ops = {
@@ -316,37 +2190,81 @@ vm_do_claim_page(struct page *page)
 	}*/
 	// 페이지가 실제로 로딩될때 = 첫번째 page fault 가 발생했을떄 호출되는 swap_in은
 	// page_fault 에서 이어지는 vm_do_claim_page 함수에서 호출됨.
-	return swap_in(page, frame->kva); // uninit_initialize
+	// 내용을 다 채운 뒤에 매핑한다. 어느 쪽이든 실패하면 프레임을 떼어내고 돌려준다.
+	// 고정된 채로 남기면 eviction 도 ksmd 도 손대지 않아 프로세스가 끝날 때까지 샌다.
+	/* : Insert page table entry to map page's VA to frame's PA. */
+	// 가상 주소와 물리 주소를 매핑. fork 중에는 부모의 페이지를 올릴 수도 있으므로 owner 의 pml4 를 쓴다.
+	if (!swap_in(page, frame->kva) || // uninit_initialize
+		!pml4_set_page(page->owner->pml4, page->va, frame->kva, page->writable))
+	{
+		vm_unclaim_frame(page, frame);
+		return false;
+	}
+	frame_unpin(frame);
+	return true;
 }
 
-/* Returns a hash value for page p. */
-unsigned
-page_hash(const struct hash_elem *p_, void *aux UNUSED)
+/* Initialize new supplemental page table */
+void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
-	const struct page *p = hash_entry(p_, struct page, hash_elem);
-	return hash_bytes(&p->va, sizeof p->va);
+	// 노드는 첫 페이지가 들어올 때 만든다.
+	spt->root = NULL;
+	spt->page_cnt = 0;
+	list_init(&spt->vmas);
+	spt->rss = spt->rss_max = 0;
+	spt->fault_cnt = spt->evict_cnt = 0;
+	spt->pff_start = timer_ticks();
+	spt->pff_cur = spt->pff_last = 0;
+	spt->prefetch_cnt = 0;
+	anon_readahead_init(spt);
 }
 
-/* Returns true if page a precedes page b. */
-bool page_less(const struct hash_elem *a_,
-			   const struct hash_elem *b_, void *aux UNUSED)
+/* Makes DST, a fresh uninit page of the child, share SRC's frame
+ * copy-on-write. Both mappings become read-only; the first write to
+ * either one copies the frame in vm_handle_wp(). */
+static bool
+vm_share_page(struct page *dst, struct page *src)
 {
-	const struct page *a = hash_entry(a_, struct page, hash_elem);
-	const struct page *b = hash_entry(b_, struct page, hash_elem);
+	struct frame *frame;
+	uint64_t *src_pml4 = src->owner->pml4;
+	bool dirty;
 
-	return a->va < b->va;
-}
+	// swap_in 없이 dst 를 부모 페이지와 같은 타입으로 초기화
+	if (!dst->uninit.page_initializer(dst, dst->uninit.type, NULL))
+		return false;
 
-/* Initialize new supplemental page table */
-void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
-{
-	hash_init(&spt->spt_hash, page_hash, page_less, NULL);
+	// 부모 페이지가 스왑 아웃되어 있으면 부모 쪽으로 다시 올린 뒤 공유한다.
+	// 공유 중인 프레임이 쫓겨나면 두 페이지 모두 각자의 슬롯으로 내보내진다.
+	lock_acquire(&frame_lock);
+	while (frame_wait_io(src) == NULL)
+	{
+		lock_release(&frame_lock);
+		if (!vm_do_claim_page(src))
+			return false;
+		lock_acquire(&frame_lock);
+	}
+	frame = src->frame;
+	frame_link(frame, dst);
+
+	// 매핑도 frame_lock 을 잡은 채로 고쳐야 그사이 쫓겨난 프레임을 매핑하지 않는다.
+	if (!pml4_set_page(dst->owner->pml4, dst->va, frame->kva, false))
+	{
+		lock_release(&frame_lock);
+		return false;
+	}
+
+	// pml4_set_page 는 PTE 를 통째로 덮어쓰므로 mmap 페이지의 dirty 비트를 살려둔다.
+	dirty = pml4_is_dirty(src_pml4, src->va);
+	pml4_set_page(src_pml4, src->va, frame->kva, false);
+	pml4_set_dirty(src_pml4, src->va, dirty);
+	lock_release(&frame_lock);
+	return true;
 }
 
 /* Copy supplemental page table from src to dst */
 // 부모프로세스가 가지고있는 본인의 spt 정보를 빠짐없이 자식 프로세스에게 복사해줌. fork 시스템콜
 // spt iteration 해주기.
-// iter 돌때마다 해당 hash_elem 과 연결된 page를 찾아서 해당 페이지 구조체의 정보들을 저장함.
+// spt_for_each 로 부모의 page 를 하나씩 받아서 해당 페이지 구조체의 정보들을 저장함.
 // vm_initializer..함수의 인자 참고
 // 부모 페이지의 정보를 저장한뒤 자식이 가질 새로운 페이지 생성.
 // 생성 위해서 부모 페이지의 타입 먼저 검사. 부모 페이지가 UNINIT페이지인 경우와 그렇지 않은 경우 ->
@@ -357,59 +2275,53 @@ void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
 								  struct supplemental_page_table *src UNUSED)
 {
+	// 부모의 페이지를 읽는 동안 prefetchd 가 그 페이지를 바꾸지 않게 한다.
+	vm_prefetch_cancel(src);
+	// 영역을 먼저 복사해 두면 부모가 아직 건드리지 않은 페이지는 자식이 알아서 만든다.
+	return vma_copy(dst, src) &&
+		   spt_for_each(src, NULL, (void *)KERN_BASE, spt_copy_page, dst);
+}
 
-	struct hash_iterator i;
-	hash_first(&i, &src->spt_hash);
-
-	while (hash_next(&i))
+/* spt_for_each() action of supplemental_page_table_copy(): makes a copy
+ * of SRC_PAGE in DST_, the child's table. */
+static bool
+spt_copy_page(struct page *src_page, void *dst_)
+{
+	struct supplemental_page_table *dst = dst_;
+	enum vm_type type = src_page->operations->type;
+	void *upage = src_page->va;
+	bool writable = src_page->writable;
+	// 1.  type == uninit
+	if (type == VM_UNINIT)
 	{
-		struct page *src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
-		enum vm_type type = src_page->operations->type;
-		void *upage = src_page->va;
-		bool writable = src_page->writable;
-		// 1.  type == uninit
-		if (type == VM_UNINIT)
-		{
-			vm_initializer *init = src_page->uninit.init;
-			void *aux = src_page->uninit.aux;
-			vm_alloc_page_with_initializer(VM_ANON, upage, writable, init, aux);
-			continue;
-		}
-		// 2. type == file_backed
-		if (type == VM_FILE)
-		{
-			struct lazy_load_arg *file_aux = malloc(sizeof(struct lazy_load_arg));
-			file_aux->file = src_page->file.file;
-			file_aux->ofs = src_page->file.ofs;
-			file_aux->read_bytes = src_page->file.read_bytes;
-			if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, file_aux))
-				return false;
-			struct page *file_page = spt_find_page(dst, upage);
-			file_backed_initializer(file_page, type, NULL);
-			pml4_set_page(thread_current()->pml4, file_page->va, src_page->frame->kva, src_page->writable);
-			continue;
-		}
-		// 3. type == anon
-		if (!vm_alloc_page(type, upage, writable)) // uninit page 생성 & 초기화
-			return false;						   // init이랑 aux는 Lazy Loading에 필요. 지금 만드는 페이지는 기다리지 않고 바로 내용을 넣어줄 것이므로 필요 없음
-
-		// vm_claim_page로 요청한 후 매핑 + 페이지 타입에 맞게 초기화
-		if (!vm_claim_page(upage))
-		{
+		// 영역에서 만들어진 페이지는 자식의 첫 fault 때 자식의 영역에서 다시 만든다.
+		if (src_page->uninit.init != NULL)
+			return true;
+		return vm_alloc_page(VM_ANON, upage, writable);
+	}
+	// 2. type == file_backed: 자식의 영역을 aux 로 넘긴다 (file_backed_initializer).
+	if (type == VM_FILE)
+	{
+		struct vma *vma = vma_find(dst, upage);
+		if (vma == NULL || !vm_alloc_page_with_initializer(type, upage, writable, NULL, vma))
 			return false;
-		}
-
-		struct page *dst_page = spt_find_page(dst, upage);
-		memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
 	}
-	return true;
+	// 3. type == anon
+	else if (!vm_alloc_page(type, upage, writable)) // uninit page 생성 & 초기화
+		return false;									// init이랑 aux는 Lazy Loading에 필요. 지금 만드는 페이지는 기다리지 않고 바로 내용을 넣어줄 것이므로 필요 없음
+
+	// 복사하지 않고 부모의 프레임을 read-only 로 같이 쓴다. 복사는 첫 쓰기 때 vm_handle_wp 에서.
+	struct page *dst_page = spt_find_page(dst, upage);
+	return vm_share_page(dst_page, src_page);
 }
-void hash_page_destroy(struct hash_elem *e, void *aux)
+/* spt_for_each() action of supplemental_page_table_kill(). */
+static bool
+spt_page_destroy(struct page *page, void *aux UNUSED)
 {
-	struct page *page = hash_entry(e, struct page, hash_elem);
-	destroy(page);
+	vm_destroy_page(page);
 	// TODO - 지우면 에러 헤결
 	// free(page);
+	return true;
 }
 /* Free the resource hold by the supplemental page table */
 // SPT가 보유하고 있던 모든 리소스를 해제하는 함수 (process_exit(), process_cleanup()에서 호출)
@@ -417,17 +2329,15 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED)
 {
 	/* : Destroy all the supplemental_page_table hold by thread and
 	 * : writeback all the modified contents to the storage. */
-	// todo: 페이지 항목들을 순회하며 테이블 내의 페이지들에 대해 destroy(page)를 호출
-	// hash_clear(&spt->spt_hash, hash_page_destroy); // 해시 테이블의 모든 요소를 제거
-
-	/** hash_destroy가 아닌 hash_clear를 사용해야 하는 이유
-	 * 여기서 hash_destroy 함수를 사용하면 hash가 사용하던 메모리(hash->bucket) 자체도 반환한다.
-	 * process가 실행될 때 hash table을 생성한 이후에 process_clean()이 호출되는데,
-	 * 이때는 hash table은 남겨두고 안의 요소들만 제거되어야 한다.
-	 * 따라서, hash의 요소들만 제거하는 hash_clear를 사용해야 한다.
-	 */
+	// 페이지 항목들을 순회하며 테이블 내의 페이지들에 대해 destroy(page)를 호출하고
+	// 노드들을 반환한다. exec 에서는 같은 spt 를 다시 쓰므로 빈 테이블로 돌려둔다.
 
 	// todo🚨: 모든 수정된 내용을 스토리지에 기록
-	hash_clear(&spt->spt_hash, hash_page_destroy);
-	// 끝? ㅇㅇ
+	vm_prefetch_cancel(spt);
+	spt_for_each(spt, NULL, (void *)KERN_BASE, spt_page_destroy, NULL);
+	if (spt->root != NULL)
+		spt_node_free(spt->root, SPT_LEVELS - 1);
+	spt->root = NULL;
+	spt->page_cnt = 0;
+	vma_free_all(spt);
 }
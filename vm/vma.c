@@ -0,0 +1,259 @@
+/* vma.c: Region descriptors for mmap() and executable segments. */
+
+#include "vm/vma.h"
+#include <string.h>
+#include "filesys/file.h"
+#include "lib/round.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Adds a region of SIZE bytes (rounded up to pages) at START to SPT.
+ * Its first READ_BYTES bytes come from FILE at OFS and the rest are
+ * zeros. The region gets its own handle to FILE. Returns NULL if the
+ * region overlaps another one or memory runs out. */
+struct vma *
+vma_add(struct supplemental_page_table *spt, void *start, size_t size,
+		struct file *file, off_t ofs, size_t read_bytes, bool writable,
+		enum vm_type type)
+{
+	struct vma *vma;
+	struct list_elem *e;
+
+	ASSERT(pg_ofs(start) == 0);
+	ASSERT(VM_TYPE(type) == VM_ANON || VM_TYPE(type) == VM_FILE);
+
+	if (size == 0 || !vma_range_free(spt, start, size))
+		return NULL;
+	vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return NULL;
+	vma->file = file_reopen(file);
+	if (vma->file == NULL)
+	{
+		free(vma);
+		return NULL;
+	}
+	vma->start = start;
+	vma->end = (uint8_t *)start + ROUND_UP(size, PGSIZE);
+	vma->ofs = ofs;
+	vma->read_bytes = read_bytes;
+	vma->writable = writable;
+	vma->type = type;
+	vma->advice = VMA_NORMAL;
+
+	// start 순서를 유지한다.
+	for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+		if (list_entry(e, struct vma, elem)->start > vma->start)
+			break;
+	list_insert(e, &vma->elem);
+	return vma;
+}
+
+/* Returns the region of SPT that contains VA, or NULL. */
+struct vma *
+vma_find(struct supplemental_page_table *spt, const void *va)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+
+		if ((const uint8_t *)va < vma->start)
+			break;
+		if ((const uint8_t *)va < vma->end)
+			return vma;
+	}
+	return NULL;
+}
+
+/* spt_for_each() action that stops at the first page. */
+static bool
+stop_at_page(struct page *page UNUSED, void *aux UNUSED)
+{
+	return false;
+}
+
+/* Returns true if no region and no page of SPT lies in the SIZE bytes
+ * at START, and the range is all user memory. */
+bool vma_range_free(struct supplemental_page_table *spt, const void *start,
+					size_t size)
+{
+	const uint8_t *end = (const uint8_t *)pg_round_down(start) + ROUND_UP(size, PGSIZE);
+	struct list_elem *e;
+
+	if (end <= (const uint8_t *)start || !is_user_vaddr(end - 1))
+		return false;
+	for (e = list_begin(&spt->vmas); e != list_end(&spt->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+
+		if (vma->start < end && (const uint8_t *)start < vma->end)
+			return false;
+	}
+	// 스택처럼 영역 없이 만들어진 페이지와도 겹치면 안 된다.
+	return spt_for_each(spt, (void *)start, (void *)end, stop_at_page, NULL);
+}
+
+/* File offset the page at VA of VMA is loaded from. */
+off_t vma_page_ofs(const struct vma *vma, const void *va)
+{
+	return vma->ofs + ((const uint8_t *)pg_round_down(va) - vma->start);
+}
+
+/* Bytes of the page at VA of VMA that come from the file. */
+size_t vma_page_read_bytes(const struct vma *vma, const void *va)
+{
+	size_t skip = (const uint8_t *)pg_round_down(va) - vma->start;
+
+	if (skip >= vma->read_bytes)
+		return 0;
+	return vma->read_bytes - skip < PGSIZE ? vma->read_bytes - skip : PGSIZE;
+}
+
+/* vm_initializer of every page made from a region; AUX is the region.
+ * A short read is an error for executable segments only: mmap() may
+ * map past the end of the file, and that part reads as zeros. */
+static bool
+vma_load_page(struct page *page, void *aux)
+{
+	struct vma *vma = aux;
+	size_t read_bytes = vma_page_read_bytes(vma, page->va);
+	off_t n = file_read_at(vma->file, page->frame->kva, read_bytes,
+						   vma_page_ofs(vma, page->va));
+
+	if (n < 0 || ((vma->type & VM_SEGMENT) && (size_t)n != read_bytes))
+		return false;
+	memset((uint8_t *)page->frame->kva + n, 0, PGSIZE - n);
+	return true;
+}
+
+/* Returns the page at VA in SPT, making it from the region that
+ * contains VA if there is no page yet. SPT must be the current
+ * thread's. Returns NULL if VA is in no page and no region. */
+struct page *
+vma_get_page(struct supplemental_page_table *spt, void *va)
+{
+	struct page *page = spt_find_page(spt, va);
+	struct vma *vma;
+
+	ASSERT(spt == &thread_current()->spt);
+
+	if (page != NULL || (vma = vma_find(spt, va)) == NULL)
+		return page;
+	va = pg_round_down(va);
+	if (!vm_alloc_page_with_initializer(vma->type, va, vma->writable,
+										vma_load_page, vma))
+		return NULL;
+	return spt_find_page(spt, va);
+}
+
+/* Copies the regions of SRC into DST for fork(). Pages are not
+ * copied; see supplemental_page_table_copy(). */
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&src->vmas); e != list_end(&src->vmas); e = list_next(e))
+	{
+		struct vma *vma = list_entry(e, struct vma, elem);
+		struct vma *copy = vma_add(dst, vma->start, vma->end - vma->start, vma->file,
+								   vma->ofs, vma->read_bytes, vma->writable, vma->type);
+
+		if (copy == NULL)
+			return false;
+		copy->advice = vma->advice;
+	}
+	return true;
+}
+
+/* spt_for_each() action of vma_unmap(). */
+static bool
+unmap_page(struct page *page, void *spt)
+{
+	spt_remove_page(spt, page);
+	return true;
+}
+
+/* Removes VMA and all of its pages from SPT, writing dirty file pages
+ * back, and closes the region's file. */
+void vma_unmap(struct supplemental_page_table *spt, struct vma *vma)
+{
+	vm_prefetch_cancel(spt);
+	spt_for_each(spt, vma->start, vma->end, unmap_page, spt);
+	list_remove(&vma->elem);
+	file_close(vma->file);
+	free(vma);
+}
+
+/* Applies ADVICE, one of enum vma_advice, to the LENGTH bytes at ADDR
+ * (madvise()). Regions have no parts, so RANDOM, SEQUENTIAL and NORMAL
+ * apply to every region the range touches, as a whole. WILLNEED queues
+ * the pages of the range for prefetchd; DONTNEED frees them, dropping
+ * changes to executable segments, so they read as first loaded on the
+ * next access. The stack is not a region (vm_stack_growth() adds its
+ * pages one by one), so it cannot be advised. Returns 0, or -1 if ADDR
+ * is not page aligned, ADVICE is unknown, part of the range is in no
+ * region or the pages for WILLNEED cannot be made; then nothing has
+ * been applied. */
+int vma_advise(struct supplemental_page_table *spt, void *addr, size_t length,
+			   int advice)
+{
+	uint8_t *start = addr;
+	uint8_t *end = start + ROUND_UP(length, PGSIZE);
+	uint8_t *p;
+
+	if (pg_ofs(addr) != 0 || end < start || advice < VMA_NORMAL || advice > VMA_DONTNEED)
+		return -1;
+	// 하나라도 영역 밖이면 아무것도 바꾸지 않는다.
+	for (p = start; p < end;)
+	{
+		struct vma *vma = vma_find(spt, p);
+
+		if (vma == NULL)
+			return -1;
+		p = vma->end;
+	}
+	// struct page 는 여기서 전부 만들어 두고, 읽기는 prefetchd 가 한다.
+	// 다 만든 뒤에야 큐에 넣으므로 실패하면 아무것도 걸리지 않는다.
+	if (advice == VMA_WILLNEED)
+		for (p = start; p < end; p += PGSIZE)
+			if (vma_get_page(spt, p) == NULL)
+				return -1;
+
+	for (p = start; p < end;)
+	{
+		struct vma *vma = vma_find(spt, p);
+		uint8_t *stop = end < vma->end ? end : vma->end;
+
+		switch (advice)
+		{
+		case VMA_WILLNEED:
+			vm_prefetch(spt, p, stop);
+			break;
+		case VMA_DONTNEED:
+			vm_prefetch_cancel(spt);
+			spt_for_each(spt, p, stop, unmap_page, spt);
+			break;
+		default:
+			vma->advice = advice;
+			break;
+		}
+		p = stop;
+	}
+	return 0;
+}
+
+/* Frees every region of SPT. The pages must already be destroyed
+ * (supplemental_page_table_kill()). */
+void vma_free_all(struct supplemental_page_table *spt)
+{
+	while (!list_empty(&spt->vmas))
+	{
+		struct vma *vma = list_entry(list_pop_front(&spt->vmas), struct vma, elem);
+
+		file_close(vma->file);
+		free(vma);
+	}
+}
@@ -0,0 +1,463 @@
+/* zswap.c: Compressed in-memory tier in front of the swap disk.
+ *
+ * anon_swap_out() first tries to keep the evicted page here, compressed
+ * with a small LZ77 codec into a pool of kernel pages. Only when the pool
+ * is full does the oldest compressed page get written back to the swap
+ * disk, so a page that comes back soon costs a decompression instead of
+ * two trips over the IDE bus. */
+
+#include "vm/zswap.h"
+#include "vm/vm.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* 풀 페이지를 ZSWAP_CHUNK 바이트 조각으로 나눠서 압축된 페이지를 담는다.
+ * 한 풀 페이지의 조각 사용 여부는 64비트 하나로 나타낸다. */
+#define ZSWAP_CHUNK 64
+#define ZSWAP_CHUNKS (PGSIZE / ZSWAP_CHUNK)
+/* 이보다 크게 압축되는 페이지는 담아봐야 이득이 적으니 바로 디스크로 보낸다. */
+#define ZSWAP_MAX_LEN (PGSIZE / 4 * 3)
+
+int vm_zswap_pages = -1;
+
+/* A kernel page of the pool. */
+struct zswap_page
+{
+	uint8_t *kva;
+	uint64_t used; /* i 번째 비트: i 번째 조각이 쓰이는 중 */
+	struct list_elem elem;
+};
+
+/* One compressed anon page. */
+struct zswap_entry
+{
+	struct page *page;	   /* 이 내용의 주인. page->anon.zswap 이 이 entry. 떼어졌으면 NULL */
+	struct zswap_page *zp; /* 담긴 풀 페이지 */
+	uint8_t chunk;		   /* zp 안의 첫 조각 */
+	uint8_t chunk_cnt;
+	uint16_t len; /* 압축된 바이트 수 */
+	bool writeback; /* 디스크로 쓰는 중. lru 에 없고, 쓰는 쪽이 해제한다 */
+	struct list_elem lru_elem;
+};
+
+/* zswap_lock 이 아래 전부와 page->anon.zswap 을 보호한다.
+ * frame_lock 다음에 잡는다. 디스크에 쓰는 동안에는 놓는다 (writeback_oldest). */
+static struct lock zswap_lock;
+static struct list pool;	   /* struct zswap_page 들 */
+static int pool_cnt;		   /* pool 의 페이지 수 */
+static struct list lru;		   /* struct zswap_entry 들. 오래된 것이 앞 */
+static zswap_writeback_func *writeback_fn;
+static zswap_slot_free_func *slot_free_fn;
+
+static uint8_t zbuf[ZSWAP_MAX_LEN]; /* 압축 결과를 잠시 담는 곳 */
+
+static long long store_cnt;		 /* # of pages stored. */
+static long long reject_cnt;	 /* # of pages that did not compress well. */
+static long long hit_cnt;		 /* # of swap-ins served from the pool. */
+static long long miss_cnt;		 /* # of swap-ins that had to read the disk. */
+static long long writeback_cnt;	 /* # of pages pushed out to the swap disk. */
+static long long bytes_in;		 /* Uncompressed bytes stored. */
+static long long bytes_out;		 /* Compressed bytes stored. */
+
+/* LZ77 codec.
+ *
+ * The output is a run of sequences. Each one is a token byte whose high
+ * nibble is a literal count and whose low nibble is a match length minus
+ * LZ_MIN_MATCH, then the literals, then a 2-byte little-endian offset
+ * back into the output. A nibble of 15 is continued in following bytes,
+ * 255 meaning "add 255 and keep reading". The last sequence has only
+ * literals, which is how the decoder knows it is done. */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+static uint16_t lz_table[1 << LZ_HASH_BITS]; /* 4바이트 hash -> 마지막 위치 */
+
+static uint32_t
+lz_read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static unsigned
+lz_hash(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static uint8_t *
+lz_put_len(uint8_t *op, size_t len)
+{
+	if (len >= 15)
+	{
+		for (len -= 15; len >= 255; len -= 255)
+			*op++ = 255;
+		*op++ = len;
+	}
+	return op;
+}
+
+/* Appends one sequence at OP, or returns NULL if it would pass OEND.
+ * MATCH_LEN of 0 makes it the last sequence. */
+static uint8_t *
+lz_emit(uint8_t *op, uint8_t *oend, const uint8_t *lit, size_t lit_len,
+		size_t offset, size_t match_len)
+{
+	size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+
+	if ((size_t)(oend - op) < 5 + lit_len + lit_len / 255 + ml / 255)
+		return NULL;
+
+	*op++ = (lit_len < 15 ? lit_len : 15) << 4 | (ml < 15 ? ml : 15);
+	op = lz_put_len(op, lit_len);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (match_len)
+	{
+		*op++ = offset & 0xff;
+		*op++ = offset >> 8;
+		op = lz_put_len(op, ml);
+	}
+	return op;
+}
+
+/* Compresses the N bytes at SRC into at most CAP bytes at DST.
+ * Returns the compressed size, or 0 if it does not fit. */
+static size_t
+lz_compress(const uint8_t *src, size_t n, uint8_t *dst, size_t cap)
+{
+	const uint8_t *ip = src, *anchor = src, *end = src + n;
+	uint8_t *op = dst, *oend = dst + cap;
+
+	memset(lz_table, 0, sizeof lz_table);
+	while (ip + LZ_MIN_MATCH <= end)
+	{
+		uint32_t v = lz_read32(ip);
+		unsigned h = lz_hash(v);
+		const uint8_t *cand = src + lz_table[h];
+		const uint8_t *mp, *cp;
+
+		lz_table[h] = ip - src;
+		if (cand >= ip || lz_read32(cand) != v)
+		{
+			ip++;
+			continue;
+		}
+
+		for (mp = ip + LZ_MIN_MATCH, cp = cand + LZ_MIN_MATCH; mp < end && *mp == *cp; mp++, cp++)
+			continue;
+		op = lz_emit(op, oend, anchor, ip - anchor, ip - cand, mp - ip);
+		if (op == NULL)
+			return 0;
+		ip = anchor = mp;
+	}
+	op = lz_emit(op, oend, anchor, end - anchor, 0, 0);
+	return op != NULL ? (size_t)(op - dst) : 0;
+}
+
+/* Reads a length continuation at *IP. Returns false if it runs past IEND. */
+static bool
+lz_get_len(const uint8_t **ip, const uint8_t *iend, size_t *len)
+{
+	uint8_t b;
+
+	do
+	{
+		if (*ip >= iend)
+			return false;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/* Decompresses LEN bytes at SRC into exactly N bytes at DST. */
+static bool
+lz_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t n)
+{
+	const uint8_t *ip = src, *iend = src + len;
+	uint8_t *op = dst, *oend = dst + n;
+
+	while (ip < iend)
+	{
+		unsigned token = *ip++;
+		size_t lit = token >> 4, ml = token & 15, offset;
+		const uint8_t *m;
+
+		if (lit == 15 && !lz_get_len(&ip, iend, &lit))
+			return false;
+		if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+			return false;
+		memcpy(op, ip, lit);
+		op += lit;
+		ip += lit;
+		if (ip == iend)
+			break;
+
+		if (iend - ip < 2)
+			return false;
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (ml == 15 && !lz_get_len(&ip, iend, &ml))
+			return false;
+		ml += LZ_MIN_MATCH;
+		if (offset == 0 || offset > (size_t)(op - dst) || ml > (size_t)(oend - op))
+			return false;
+		// 겹칠 수 있으므로 한 바이트씩 복사한다.
+		for (m = op - offset; ml > 0; ml--)
+			*op++ = *m++;
+	}
+	return op == oend;
+}
+
+/* Returns the mask of CNT chunks starting at chunk FIRST. */
+static uint64_t
+chunk_mask(size_t first, size_t cnt)
+{
+	return (cnt == ZSWAP_CHUNKS ? ~0ULL : (1ULL << cnt) - 1) << first;
+}
+
+/* Finds CNT free chunks in a row in the pool for ENTRY.
+ * Grows the pool by one page if nothing fits and there is room. */
+static bool
+chunk_alloc(struct zswap_entry *entry, size_t cnt)
+{
+	struct list_elem *e;
+	struct zswap_page *zp;
+
+	for (e = list_begin(&pool); e != list_end(&pool); e = list_next(e))
+	{
+		zp = list_entry(e, struct zswap_page, elem);
+		for (size_t i = 0; i + cnt <= ZSWAP_CHUNKS; i++)
+			if ((zp->used & chunk_mask(i, cnt)) == 0)
+			{
+				zp->used |= chunk_mask(i, cnt);
+				entry->zp = zp;
+				entry->chunk = i;
+				entry->chunk_cnt = cnt;
+				return true;
+			}
+	}
+
+	if (pool_cnt >= vm_zswap_pages || (zp = malloc(sizeof *zp)) == NULL)
+		return false;
+	if ((zp->kva = palloc_get_page(0)) == NULL)
+	{
+		free(zp);
+		return false;
+	}
+	zp->used = chunk_mask(0, cnt);
+	list_push_back(&pool, &zp->elem);
+	pool_cnt++;
+	entry->zp = zp;
+	entry->chunk = 0;
+	entry->chunk_cnt = cnt;
+	return true;
+}
+
+/* Frees ENTRY, which is in no list and belongs to no page, and its
+ * chunks, and the pool page if it became empty. */
+static void
+entry_free(struct zswap_entry *entry)
+{
+	struct zswap_page *zp = entry->zp;
+
+	zp->used &= ~chunk_mask(entry->chunk, entry->chunk_cnt);
+	if (zp->used == 0)
+	{
+		list_remove(&zp->elem);
+		palloc_free_page(zp->kva);
+		free(zp);
+		pool_cnt--;
+	}
+	free(entry);
+}
+
+/* Takes ENTRY away from its page. An entry being written back is only
+ * detached; writeback_oldest() frees it when the write is done. */
+static void
+entry_drop(struct zswap_entry *entry)
+{
+	entry->page->anon.zswap = NULL;
+	entry->page = NULL;
+	if (!entry->writeback)
+	{
+		list_remove(&entry->lru_elem);
+		entry_free(entry);
+	}
+}
+
+static bool
+entry_decompress(struct zswap_entry *entry, void *kva)
+{
+	return lz_decompress(entry->zp->kva + entry->chunk * ZSWAP_CHUNK, entry->len,
+						 kva, PGSIZE);
+}
+
+/* Writes the oldest page in the pool back to the swap disk and drops
+ * it. Must hold zswap_lock, which is released for the decompression
+ * and the write, so that swap-in faults served from the pool and other
+ * stores do not wait for the disk. Meanwhile the entry is off the LRU
+ * and marked writeback but keeps its chunks: a zswap_load() of its
+ * page still decompresses it, and that or a zswap_invalidate() only
+ * detaches it, after which the slot just written is freed again.
+ * Returns false if the pool is empty or the disk is full. */
+static bool
+writeback_oldest(void)
+{
+	struct zswap_entry *entry;
+	uint8_t *buf;
+	int slot;
+
+	if (list_empty(&lru) || (buf = palloc_get_page(0)) == NULL)
+		return false;
+	entry = list_entry(list_pop_front(&lru), struct zswap_entry, lru_elem);
+	entry->writeback = true;
+	lock_release(&zswap_lock);
+
+	if (!entry_decompress(entry, buf))
+		PANIC("zswap: corrupt entry");
+	slot = writeback_fn(buf);
+	palloc_free_page(buf);
+
+	lock_acquire(&zswap_lock);
+	entry->writeback = false;
+	if (entry->page == NULL)
+	{
+		// 쓰는 사이에 주인이 읽어 갔거나 버렸다. 자리는 어쨌든 비었다.
+		if (slot != -1)
+			slot_free_fn(slot);
+		entry_free(entry);
+		return true;
+	}
+	if (slot == -1)
+	{
+		list_push_front(&lru, &entry->lru_elem);
+		return false;
+	}
+	entry->page->anon.swap_sec = slot;
+	entry->page->anon.zswap = NULL;
+	entry_free(entry);
+	writeback_cnt++;
+	return true;
+}
+
+void zswap_init(zswap_writeback_func *writeback, zswap_slot_free_func *slot_free)
+{
+	lock_init(&zswap_lock);
+	list_init(&pool);
+	list_init(&lru);
+	pool_cnt = 0;
+	writeback_fn = writeback;
+	slot_free_fn = slot_free;
+	if (vm_zswap_pages < 0)
+		vm_zswap_pages = palloc_user_page_cnt() / 4;
+}
+
+/* Keeps a compressed copy of the page at KVA for PAGE, writing older
+ * pages back to disk to make room. Returns false if PAGE has to go to
+ * the swap disk itself. */
+bool zswap_store(struct page *page, const void *kva)
+{
+	struct zswap_entry *entry;
+	size_t len;
+
+	if (vm_zswap_pages == 0)
+		return false;
+
+	if ((entry = malloc(sizeof *entry)) == NULL)
+		return false;
+	lock_acquire(&zswap_lock);
+	// writeback_oldest() 가 lock 을 놓는 사이 다른 store 가 zbuf 를 쓸 수 있으므로
+	// 자리가 날 때까지 매번 다시 압축한다. 디스크 쓰기에 비하면 싸다.
+	for (;;)
+	{
+		len = lz_compress(kva, PGSIZE, zbuf, sizeof zbuf);
+		if (len == 0)
+		{
+			reject_cnt++;
+			lock_release(&zswap_lock);
+			free(entry);
+			return false;
+		}
+		if (chunk_alloc(entry, DIV_ROUND_UP(len, ZSWAP_CHUNK)))
+			break;
+		if (!writeback_oldest())
+		{
+			lock_release(&zswap_lock);
+			free(entry);
+			return false;
+		}
+	}
+
+	memcpy(entry->zp->kva + entry->chunk * ZSWAP_CHUNK, zbuf, len);
+	entry->page = page;
+	entry->len = len;
+	entry->writeback = false;
+	list_push_back(&lru, &entry->lru_elem);
+	page->anon.zswap = entry;
+	store_cnt++;
+	bytes_in += PGSIZE;
+	bytes_out += len;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* If PAGE's contents are in the pool, decompresses them into KVA,
+ * drops them from the pool and returns true. */
+bool zswap_load(struct page *page, void *kva)
+{
+	struct zswap_entry *entry;
+
+	lock_acquire(&zswap_lock);
+	entry = page->anon.zswap;
+	if (entry == NULL)
+	{
+		miss_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	if (!entry_decompress(entry, kva))
+		PANIC("zswap: corrupt entry");
+	entry_drop(entry);
+	hit_cnt++;
+	lock_release(&zswap_lock);
+	return true;
+}
+
+/* Drops PAGE's contents from the pool, if they are there.
+ * Returns true if they were. */
+bool zswap_invalidate(struct page *page)
+{
+	bool found;
+
+	lock_acquire(&zswap_lock);
+	found = page->anon.zswap != NULL;
+	if (found)
+		entry_drop(page->anon.zswap);
+	lock_release(&zswap_lock);
+	return found;
+}
+
+/* Prints zswap statistics. */
+void zswap_print_stats(void)
+{
+	long long ratio = bytes_out > 0 ? bytes_in * 100 / bytes_out : 0;
+	long long loads = hit_cnt + miss_cnt;
+
+	printf("zswap: %lld pages stored, %lld incompressible, ratio %lld.%02lld, "
+		   "%d/%d pool pages\n",
+		   store_cnt, reject_cnt, ratio / 100, ratio % 100, pool_cnt, vm_zswap_pages);
+	printf("zswap: %lld hits, %lld misses (%lld%% hit rate), %lld written back, "
+		   "%lld disk writes saved\n",
+		   hit_cnt, miss_cnt, loads > 0 ? hit_cnt * 100 / loads : 0,
+		   writeback_cnt, store_cnt - writeback_cnt);
+}